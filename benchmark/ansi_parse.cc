@@ -0,0 +1,65 @@
+#include <term/ansi.hh>
+#include <term/text.hh>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using jwezel::AnsiParser;
+using std::format, std::string, std::string_view;
+using std::chrono::steady_clock, std::chrono::duration_cast, std::chrono::microseconds;
+
+namespace {
+
+const size_t InputSize{size_t{64} << 20U};
+const size_t ChunkSize{size_t{64} << 10U};
+
+///
+/// Repeat sample to the input size
+///
+/// @param[in]  sample  The sample
+///
+/// @return     The input
+auto input(string_view sample) -> string {
+  string result;
+  result.reserve(InputSize + sample.size());
+  while (result.size() < InputSize) {
+    result += sample;
+  }
+  return result;
+}
+
+///
+/// Run benchmark
+///
+/// @param[in]  name    The name
+/// @param[in]  sample  The sample repeated as input
+void run(string_view name, string_view sample) {
+  const auto bytes{input(sample)};
+  AnsiParser parser;
+  size_t lines{0};
+  const auto start{steady_clock::now()};
+  for (size_t offset = 0; offset < bytes.size(); offset += ChunkSize) {
+    lines += parser.parse(string_view{bytes}.substr(offset, ChunkSize)).take().data.size();
+  }
+  const auto elapsed{duration_cast<microseconds>(steady_clock::now() - start).count()};
+  std::cout << format(
+    "{:>10} {:>10} {:>10} {:>10}\n", name, lines, elapsed, size_t(double(bytes.size()) / double(elapsed))
+  );
+}
+
+} // namespace
+
+auto main() -> int {
+  std::cout << format("{:>10} {:>10} {:>10} {:>10}\n", "Input", "Lines", "Time/us", "MB/s");
+  run("plain", "[ RUN      ] SurfaceTest.MovesElementsAroundWithoutFlicker and some more text\n");
+  run(
+    "coloured",
+    "\x1b[1msrc/term/file.cc:42:7:\x1b[m \x1b[1;31merror:\x1b[m expected \x1b[1m';'\x1b[m before "
+    "\x1b[1m'}'\x1b[m token\n"
+  );
+  run("unicode", "Größe der Ausgabe: 42 äöü — fertig\n");
+  return 0;
+}
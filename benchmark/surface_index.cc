@@ -0,0 +1,113 @@
+#include <term/device.hh>
+#include <term/geometry.hh>
+#include <term/surface.hh>
+#include <term/text.hh>
+#include <term/update.hh>
+#include <term/window.hh>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using
+  jwezel::Backdrop,
+  jwezel::Char,
+  jwezel::Device,
+  jwezel::Dim,
+  jwezel::Rectangle,
+  jwezel::Surface,
+  jwezel::TextElement,
+  jwezel::Updates,
+  jwezel::Vector;
+using std::format, std::vector, std::unique_ptr;
+using std::chrono::steady_clock, std::chrono::duration_cast, std::chrono::microseconds;
+
+namespace {
+
+const Vector ScreenSize{200, 60};
+const auto Moves{500};
+const auto HitTests{200000};
+
+///
+/// Device discarding updates
+struct NullDevice: Device {
+  void update(const Updates &/*updates*/) override {}
+};
+
+///
+/// Linear congruential generator, so that all runs see the same windows
+struct Random {
+  auto operator()(int limit) -> int {
+    seed_ = seed_ * 1103515245U + 12345U;
+    return int((seed_ >> 16U) % unsigned(limit));
+  }
+
+  auto area() -> Rectangle {
+    const auto x{Dim((*this)(ScreenSize.x() - 10))}, y{Dim((*this)(ScreenSize.y() - 3))};
+    return Rectangle{x, y, Dim(x + 10 + (*this)(40)), Dim(y + 3 + (*this)(15))};
+  }
+
+  unsigned seed_{1};
+};
+
+auto elapsed(steady_clock::time_point start) -> long {
+  return long(duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+///
+/// Run benchmark
+///
+/// @param[in]  windows  Number of windows
+/// @param[in]  index    The spatial index
+void run(int windows, Surface::SpatialIndex index) {
+  NullDevice device;
+  Surface surface{&device};
+  surface.spatialIndex(index);
+  Backdrop backdrop{&surface};
+  Random random;
+  vector<unique_ptr<TextElement>> elements;
+  auto start{steady_clock::now()};
+  for (auto i = 0; i < windows; ++i) {
+    elements.push_back(std::make_unique<TextElement>(&surface, random.area(), Char('a' + i % 26)));
+  }
+  const auto add{elapsed(start)};
+  start = steady_clock::now();
+  for (auto i = 0; i < Moves; ++i) {
+    elements[random(windows)]->move(random.area());
+  }
+  const auto move{elapsed(start)};
+  start = steady_clock::now();
+  size_t hits{0};
+  for (auto i = 0; i < HitTests; ++i) {
+    hits += surface.find(Vector{Dim(random(ScreenSize.x())), Dim(random(ScreenSize.y()))}) != 0;
+  }
+  const auto find{elapsed(start)};
+  std::cout << format(
+    "{:>5} {:>6} {:>9} {:>10} {:>10} {:>10}\n",
+    windows,
+    index == Surface::SpatialIndex::grid? "grid": "rtree",
+    surface.fragmentCount(),
+    add,
+    move,
+    find
+  );
+  if (hits != HitTests) {
+    std::cerr << format("{} of {} hit tests failed\n", HitTests - hits, HitTests);
+  }
+}
+
+} // namespace
+
+auto main() -> int {
+  std::cout << format(
+    "{:>5} {:>6} {:>9} {:>10} {:>10} {:>10}\n", "Wins", "Index", "Fragments", "Add/us", "Moves/us", "Finds/us"
+  );
+  for (const auto windows: {10, 100, 1000}) {
+    for (const auto index: {Surface::SpatialIndex::rtree, Surface::SpatialIndex::grid}) {
+      run(windows, index);
+    }
+  }
+  return 0;
+}
@@ -57,6 +57,7 @@ auto main(int /*unused*/, char * /*unused*/[]) -> int {
   const Vector si{wi, hi};
   Terminal term{Char(L' ', RgbNone, RgbCyan2), VectorMin, VectorMin, VectorMax, 1, 0, true, false};
   term.display().mouseMode(jwezel::Display::MouseMode::anything);
+  term.display().keyboardProtocol(true);
   vector<std::unique_ptr<jwezel::Window>> ws;
   u4 cw = 0;
   ws.push_back(std::make_unique<jwezel::Window>(&term, Rectangle{0, 0, wi, hi}, Char(' ', RgbNone, RgbBlue5)));
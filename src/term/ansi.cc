@@ -0,0 +1,406 @@
+#include "ansi.hh"
+#include "text.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#include <utf8cpp/utf8.h>
+
+namespace jwezel {
+
+using std::array, std::string_view;
+
+namespace {
+
+const u1 Escape{0x1b};
+
+const Unicode ReplacementRune{0xfffd};
+
+const u8
+  Ones{0x0101010101010101ULL},
+  High{0x8080808080808080ULL};
+
+///
+/// Get 256 colour palette of xterm
+///
+/// @return     The palette
+auto palette() -> array<Rgb, 256> {
+  static const array<array<int, 3>, 16> system{{
+    {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+    {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0},
+    {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255}
+  }};
+  static const array<int, 6> levels{0, 95, 135, 175, 215, 255};
+  array<Rgb, 256> result;
+  const auto set{[&](size_t index, int r, int g, int b) {
+    const Rgb color{f4(r) / HighColor, f4(g) / HighColor, f4(b) / HighColor};
+    result.at(index) = color;
+  }};
+  for (size_t index = 0; index < system.size(); ++index) {
+    set(index, system.at(index)[0], system.at(index)[1], system.at(index)[2]);
+  }
+  for (size_t index = 0; index < 216; ++index) {
+    set(16 + index, levels.at(index / 36), levels.at(index / 6 % 6), levels.at(index % 6));
+  }
+  for (int index = 0; index < 24; ++index) {
+    set(size_t(232 + index), 8 + 10 * index, 8 + 10 * index, 8 + 10 * index);
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+const array<Rgb, 256> Palette{palette()};
+
+///
+/// Get length of a run of printable ASCII
+///
+/// Checks 8 bytes at a time: a byte is printable if its high bit is clear and
+/// adding 0x60 sets it while adding 1 does not.
+///
+/// @param[in]  begin  The begin
+/// @param[in]  end    The end
+///
+/// @return     The length
+auto printable(const char *begin, const char *end) -> size_t {
+  const auto *position{begin};
+  for (; end - position >= 8; position += 8) {
+    u8 word;
+    std::memcpy(&word, position, sizeof(word));
+    const auto low{word & ~High};
+    if (((word | ~(low + Ones * 0x60) | (low + Ones)) & High) != 0) {
+      break;
+    }
+  }
+  while (position != end and u1(*position) >= 0x20 and u1(*position) < 0x7f) {
+    ++position;
+  }
+  return size_t(position - begin);
+}
+
+///
+/// Get length of UTF-8 sequence
+///
+/// @param[in]  byte  The first byte
+///
+/// @return     The length, 0 if the byte cannot start a sequence
+auto sequenceLength(u1 byte) -> size_t {
+  return byte < 0x80? 1: (byte & 0xe0U) == 0xc0? 2: (byte & 0xf0U) == 0xe0? 3: (byte & 0xf8U) == 0xf0? 4: 0;
+}
+
+} // namespace
+
+AnsiParser::AnsiParser(const CharAttributes &attributes):
+defaults_{attributes},
+attributes_{attributes}
+{}
+
+auto AnsiParser::parse(string_view chunk) -> AnsiParser & {
+  const auto *position{chunk.data()};
+  const auto *end{position + chunk.size()};
+  while (position != end) {
+    if (state_ == State::text and expected_ == 0) {
+      const auto run{printable(position, end)};
+      write(position, run);
+      position += run;
+      if (position == end) {
+        break;
+      }
+      const auto length{sequenceLength(u1(*position))};
+      if (length > 1 and size_t(end - position) >= length and utf8::is_valid(position, position + length)) {
+        // Complete character in the chunk
+        put(Unicode(utf8::next(position, position + length)));
+        continue;
+      }
+    }
+    parse(u1(*position++));
+  }
+  return *this;
+}
+
+auto AnsiParser::take() -> Text {
+  Text result;
+  result.data.swap(text_.data);
+  return result;
+}
+
+void AnsiParser::reset() {
+  attributes_ = defaults_;
+  text_.data.clear();
+  line_.clear();
+  column_ = 0;
+  state_ = State::text;
+  pending_.clear();
+  expected_ = 0;
+}
+
+void AnsiParser::write(const char *bytes, size_t length) {
+  if (column_ == line_.size()) {
+    if (line_.capacity() < line_.size() + length) {
+      line_.reserve(std::max(line_.size() + length, 2 * line_.capacity()));
+    }
+    Char cell{' ', attributes_};
+    for (size_t index = 0; index < length; ++index) {
+      cell.rune = Unicode(u1(bytes[index]));
+      line_.push_back(cell);
+    }
+    column_ += length;
+  } else {
+    for (size_t index = 0; index < length; ++index) {
+      put(Unicode(u1(bytes[index])));
+    }
+  }
+}
+
+void AnsiParser::put(Unicode rune) {
+  if (column_ < line_.size()) {
+    line_[column_] = Char(rune, attributes_);
+  } else {
+    line_.resize(column_, Char(' ', attributes_));
+    line_.emplace_back(rune, attributes_);
+  }
+  ++column_;
+}
+
+void AnsiParser::parse(u1 byte) {
+  switch (state_) {
+    case State::text:
+      if (expected_ > 0 or byte >= 0x80) {
+        character(byte);
+        return;
+      }
+      switch (byte) {
+        case '\n': {
+          // The next line is likely to be as long
+          const auto size{line_.size()};
+          text_.data.push_back(std::move(line_));
+          line_ = String{};
+          line_.reserve(size);
+          column_ = 0;
+          break;
+        }
+        case '\r':
+          column_ = 0;
+          break;
+        case '\b':
+          column_ -= column_ > 0;
+          break;
+        case '\t':
+          column_ = (column_ / TabSize + 1) * TabSize;
+          if (column_ > line_.size()) {
+            line_.resize(column_, Char(' ', attributes_));
+          }
+          break;
+        case Escape:
+          state_ = State::escape;
+          break;
+        default:
+          if (byte >= 0x20 and byte < 0x7f) {
+            put(byte);
+          }
+          // Other control characters are ignored
+      }
+      break;
+    case State::escape:
+      if (byte == '[') {
+        state_ = State::csi;
+        parameters_[0] = 0;
+        parameterCount_ = 1;
+        subParameters_.reset();
+        ignored_ = false;
+      } else if (byte == ']' or byte == 'P' or byte == 'X' or byte == '^' or byte == '_') {
+        state_ = State::string;
+      } else if (byte < 0x20) {
+        // Control characters and another ESC cut the sequence short and take effect
+        state_ = State::text;
+        parse(byte);
+      } else if (byte >= 0x30) {
+        // Bytes 0x20 to 0x2f are intermediates followed by the final byte
+        state_ = State::text;
+      }
+      break;
+    case State::csi:
+      control(byte);
+      break;
+    case State::string:
+      if (byte == '\a') {
+        state_ = State::text;
+      } else if (byte == Escape) {
+        state_ = State::stringEnd;
+      }
+      break;
+    case State::stringEnd:
+      state_ = byte == '\\'? State::text: byte == Escape? State::stringEnd: State::string;
+      break;
+  }
+}
+
+void AnsiParser::character(u1 byte) {
+  if ((byte & 0xc0U) == 0x80 and expected_ > 0) {
+    pending_ += char(byte);
+    if (pending_.size() == expected_) {
+      auto position{pending_.begin()};
+      put(utf8::is_valid(pending_.begin(), pending_.end())? Unicode(utf8::next(position, pending_.end())): ReplacementRune);
+      pending_.clear();
+      expected_ = 0;
+    }
+    return;
+  }
+  if (expected_ > 0) {
+    // Character cut short
+    put(ReplacementRune);
+    pending_.clear();
+    expected_ = 0;
+    if (byte < 0x80) {
+      parse(byte);
+      return;
+    }
+  }
+  expected_ = sequenceLength(byte);
+  if (expected_ < 2) {
+    expected_ = 0;
+    put(ReplacementRune);
+  } else {
+    pending_ += char(byte);
+  }
+}
+
+void AnsiParser::control(u1 byte) {
+  if (byte >= '0' and byte <= '9') {
+    if (parameterCount_ <= MaxParameters) {
+      auto &parameter{parameters_.at(parameterCount_ - 1)};
+      parameter = u2(std::min(parameter * 10 + (byte - '0'), 0xffff));
+    }
+  } else if (byte == ';' or byte == ':') {
+    if (++parameterCount_ <= MaxParameters) {
+      parameters_.at(parameterCount_ - 1) = 0;
+      subParameters_[parameterCount_ - 1] = byte == ':';
+    }
+  } else if (byte >= 0x20 and byte < 0x40) {
+    // Private parameters and intermediates
+    ignored_ = true;
+  } else if (byte >= 0x40 and byte < 0x7f) {
+    state_ = State::text;
+    if (!ignored_) {
+      if (byte == 'm') {
+        select();
+      } else if (byte == 'K') {
+        erase(parameters_[0]);
+      }
+    }
+  } else if (byte == Escape) {
+    state_ = State::escape;
+  }
+}
+
+void AnsiParser::select() {
+  const auto count{std::min(parameterCount_, MaxParameters)};
+  for (size_t index = 0; index < count; ++index) {
+    const auto parameter{parameters_.at(index)};
+    // Sub-parameters separated by colons belong to this parameter
+    auto next{index + 1};
+    while (next < count and subParameters_[next]) {
+      ++next;
+    }
+    switch (parameter) {
+      case 0:
+        attributes_ = defaults_;
+        break;
+      case 1:
+        attributes_.attr = Attributes(attributes_.attr | bold);
+        break;
+      case 4:
+        attributes_.attr = Attributes(attributes_.attr | underline);
+        break;
+      case 5:
+      case 6:
+        attributes_.attr = Attributes(attributes_.attr | blink);
+        break;
+      case 7:
+        attributes_.attr = Attributes(attributes_.attr | reverse);
+        break;
+      case 22:
+        attributes_.attr = Attributes(attributes_.attr & ~bold);
+        break;
+      case 24:
+        attributes_.attr = Attributes(attributes_.attr & ~underline);
+        break;
+      case 25:
+        attributes_.attr = Attributes(attributes_.attr & ~blink);
+        break;
+      case 27:
+        attributes_.attr = Attributes(attributes_.attr & ~reverse);
+        break;
+      case 38:
+      case 48: {
+        auto &color{parameter == 38? attributes_.fg: attributes_.bg};
+        if (next > index + 1) {
+          // 38:5:n, 38:2:r:g:b or 38:2:id:r:g:b with a colour space id
+          const auto subCount{next - index - 1};
+          if (subCount >= 2 and parameters_.at(index + 1) == 5) {
+            color = Palette.at(parameters_.at(index + 2) & 0xffU);
+          } else if (subCount >= 4 and parameters_.at(index + 1) == 2) {
+            const auto value{rgb(next - 3)};
+            color = value;
+          }
+        } else if (index + 2 < count and parameters_.at(index + 1) == 5) {
+          color = Palette.at(parameters_.at(index + 2) & 0xffU);
+          index += 2;
+        } else if (index + 4 < count and parameters_.at(index + 1) == 2) {
+          const auto value{rgb(index + 2)};
+          color = value;
+          index += 4;
+        } else {
+          index = count;
+        }
+        break;
+      }
+      case 39:
+        attributes_.fg = defaults_.fg;
+        break;
+      case 49:
+        attributes_.bg = defaults_.bg;
+        break;
+      default:
+        if (parameter >= 30 and parameter < 38) {
+          attributes_.fg = Palette.at(parameter - 30);
+        } else if (parameter >= 40 and parameter < 48) {
+          attributes_.bg = Palette.at(parameter - 40);
+        } else if (parameter >= 90 and parameter < 98) {
+          attributes_.fg = Palette.at(parameter - 90 + 8);
+        } else if (parameter >= 100 and parameter < 108) {
+          attributes_.bg = Palette.at(parameter - 100 + 8);
+        }
+        // Other parameters are not supported
+    }
+    index = std::max(index, next - 1);
+  }
+}
+
+auto AnsiParser::rgb(size_t index) const -> Rgb {
+  return Rgb{
+    f4(std::min<int>(parameters_.at(index), HighColor)) / HighColor,
+    f4(std::min<int>(parameters_.at(index + 1), HighColor)) / HighColor,
+    f4(std::min<int>(parameters_.at(index + 2), HighColor)) / HighColor
+  };
+}
+
+void AnsiParser::erase(u2 mode) {
+  switch (mode) {
+    case 0:
+      line_.resize(std::min(line_.size(), column_));
+      break;
+    case 1:
+      std::fill_n(line_.begin(), std::min(line_.size(), column_ + 1), Char(' ', attributes_));
+      break;
+    case 2:
+      line_.clear();
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace jwezel
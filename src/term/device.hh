@@ -36,6 +36,38 @@ struct Device {
   ///
   /// @param[in]  updates  The updates
   virtual void update(const jwezel::Updates &updates) = 0;
+
+  ///
+  /// Get area shown by the device
+  ///
+  /// Content outside of it is not sent to the device.
+  ///
+  /// @return     The area
+  [[nodiscard]] virtual auto area() const -> Rectangle {return RectangleMax;}
+
+  ///
+  /// Move content shown on the device
+  ///
+  /// Devices keeping the composited content can shift it instead of getting
+  /// updates for content that merely moved. Either all areas are moved or none.
+  ///
+  /// @param[in]  areas   The areas to move
+  /// @param[in]  offset  The offset to move them by
+  ///
+  /// @return     True if the areas were moved, false if updates are needed
+  virtual auto move(const vector<Rectangle> &/*areas*/, const Vector &/*offset*/) -> bool {return false;}
+
+  ///
+  /// Fill area with character
+  ///
+  /// Content that is the same character throughout is offered as a fill, so
+  /// that devices able to handle it need not get its text.
+  ///
+  /// @param[in]  area  The area, which may extend beyond the device
+  /// @param[in]  ch    The character
+  ///
+  /// @return     True if the area was filled, false if an update is needed
+  virtual auto fill(const Rectangle &/*area*/, const Char &/*ch*/) -> bool {return false;}
 };
 
 } // namespace jwezel
@@ -1,5 +1,6 @@
 #include "display.hh"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <exception>
@@ -14,6 +15,19 @@
 
 namespace jwezel {
 
+namespace {
+
+///
+/// Minimum number of changed cells for which an area is filled with DECFRA or
+/// DECERA rather than written char by char
+const auto MinFillCells{16};
+
+///
+/// Primary device attribute for rectangular editing
+const auto RectangularEditing{28};
+
+} // namespace
+
 using std::format;
 using
   std::array,
@@ -22,6 +36,7 @@ using
   std::exception,
   std::runtime_error,
   std::smatch,
+  std::sregex_iterator,
   std::system_category,
   std::system_error;
 
@@ -59,6 +74,7 @@ Display::~Display() {
     background(RgbNone);
     attributes({});
     cursor(0, toDim(size().y() + position_.y() - 1));
+    keyboardProtocol(false);
     write("\x1b[?9l\x1b[?1000l\x1b[?1002l\x1b[?1003l\n");
   } catch (exception & error) {
     cerr << "Error: " << error.what() << "\n";
@@ -78,6 +94,7 @@ void Display::write(const string_view &str) const {
       }
       wt += wc;
     }
+    written_ += wt;
   }
 }
 
@@ -189,37 +206,191 @@ void Display::update(const Vector &position, const Text &text) {
     return;
   }
   auto textArea{area.value() - position};
+  if (rectangular_) {
+    const auto &first{text.data[textArea.y1()][textArea.x1()]};
+    auto uniform{true};
+    for (Dim line = textArea.y1(); uniform and line < textArea.y2(); ++line) {
+      uniform = std::all_of(
+        text.data[line].begin() + textArea.x1(),
+        text.data[line].begin() + textArea.x2(),
+        [&first](const Char &ch) {return ch == first;}
+      );
+    }
+    if (uniform and rectangularFill(area.value(), first)) {
+      return;
+    }
+  }
   for (Dim line = textArea.y1(), dline = area.value().y1(); line < textArea.y2(); ++line, ++dline) {
     assert(line < toDim(text.data.size()));
     while (toDim(line + position.y()) >= text_.height()) {
       text_.data.emplace_back(text.data[line].size(), Null);
     }
     for (Dim column = textArea.x1(), dcolumn = area.value().x1(); column < textArea.x2(); ++column, ++dcolumn) {
-      const auto &ch{text.data[line][column]};
-      if (text_.data[dline][dcolumn] != ch) {
-        cursor(toDim(dcolumn + position_.x()), toDim(dline + position_.y()));
-        foreground(ch.attributes.fg);
-        background(ch.attributes.bg);
-        attributes(ch.attributes.attr);
-        write(ch.utf8());
-        cursor_ = cursor_.right();
-        if (cursor_.x() > maxSize_.x()) {
-          cursor_ = Vector{0, cursor_.y()};
-          cursor_ = cursor_.down();
-        }
-        assert(dcolumn < (int)text_.data[dline].size()); // NOLINT
-        text_.data[dline][dcolumn] = ch;
-      }
+      put(dcolumn, dline, text.data[line][column]);
     }
   }
 }
 
+void Display::put(Dim column, Dim line, const Char &ch) {
+  assert(column < (int)text_.data[line].size()); // NOLINT
+  if (text_.data[line][column] != ch) {
+    cursor(toDim(column + position_.x()), toDim(line + position_.y()));
+    foreground(ch.attributes.fg);
+    background(ch.attributes.bg);
+    attributes(ch.attributes.attr);
+    write(ch.utf8());
+    cursor_ = cursor_.right();
+    if (cursor_.x() > maxSize_.x()) {
+      cursor_ = Vector{0, cursor_.y()};
+      cursor_ = cursor_.down();
+    }
+    text_.data[line][column] = ch;
+  }
+}
+
 void Display::update(const Updates &updates) {
   for (const auto &update_: updates) {
     update(update_.position, update_.text);
   }
 }
 
+auto Display::move(const vector<Rectangle> &areas, const Vector &offset) -> bool {
+  const Rectangle screen{Vector{0, 0}, size()};
+  for (const auto &area: areas) {
+    if ((area & screen) != area or (area + offset & screen) != area + offset) {
+      return false;
+    }
+  }
+  if (rectangular_) {
+    // Copy areas moving towards others first, so that no source is overwritten before it is copied
+    auto ordered{areas};
+    std::ranges::sort(ordered, [&offset](const Rectangle &a, const Rectangle &b) {
+      if (a.y1() != b.y1()) {
+        return offset.y() > 0? a.y1() > b.y1(): a.y1() < b.y1();
+      }
+      return offset.x() > 0? a.x1() > b.x1(): a.x1() < b.x1();
+    });
+    vector<Text> contents;
+    contents.reserve(ordered.size());
+    for (const auto &area: ordered) {
+      const auto source{area + position_};
+      const auto destination{source.position() + offset};
+      write(
+        format(
+          "\x1b[{};{};{};{};1;{};{};1$v",
+          source.y1() + 1,
+          source.x1() + 1,
+          source.y2(),
+          source.x2(),
+          destination.y() + 1,
+          destination.x() + 1
+        )
+      );
+      contents.push_back(text_[area]);
+    }
+    for (size_t index = 0; index < ordered.size(); ++index) {
+      const auto destination{ordered[index].position() + offset};
+      for (Dim line = 0; line < contents[index].height(); ++line) {
+        std::ranges::copy(contents[index].data[line], text_.data[destination.y() + line].begin() + destination.x());
+      }
+    }
+    return true;
+  }
+  if (areas.size() == 1 and scroll(areas[0], offset)) {
+    return true;
+  }
+  // Take all content before writing, as areas may overlap destinations
+  Updates updates;
+  updates.reserve(areas.size());
+  for (const auto &area: areas) {
+    updates.emplace_back(area.position() + offset, text_[area]);
+  }
+  update(updates);
+  return true;
+}
+
+auto Display::scroll(const Rectangle &area, const Vector &offset) -> bool {
+  // Scroll regions span whole terminal lines
+  if (
+    offset.x() != 0 or offset.y() == 0 or area.x1() != 0 or area.x2() != size().x() or
+    position_.x() != 0 or size().x() != terminalSize_.x()
+  ) {
+    return false;
+  }
+  const auto top{std::min(area.y1(), Dim(area.y1() + offset.y()))};
+  const auto bottom{std::max(area.y2(), Dim(area.y2() + offset.y()))};
+  // Lines scrolled in are blank in the default rendition
+  foreground(RgbNone);
+  background(RgbNone);
+  attributes({});
+  write(
+    format(
+      "\x1b[{};{}r\x1b[{}{}\x1b[r",
+      top + position_.y() + 1,
+      bottom + position_.y(),
+      std::abs(offset.y()),
+      offset.y() < 0? 'S': 'T'
+    )
+  );
+  // Setting the scroll region homes the cursor
+  cursor_ = Vector{0, 0};
+  text_.scroll(Rectangle{0, top, size().x(), bottom}, Dim(-offset.y()), Space);
+  return true;
+}
+
+auto Display::fill(const Rectangle &area, const Char &ch) -> bool {
+  const auto screenArea{area & Rectangle{Vector{0, 0}, size()}};
+  if (!screenArea or rectangular_ and rectangularFill(screenArea.value(), ch)) {
+    return true;
+  }
+  for (Dim line = screenArea->y1(); line < screenArea->y2(); ++line) {
+    for (Dim column = screenArea->x1(); column < screenArea->x2(); ++column) {
+      put(column, line, ch);
+    }
+  }
+  return true;
+}
+
+auto Display::rectangularFill(const Rectangle &area, const Char &ch) -> bool {
+  static const Unicode FirstPrintable{32}, LastPrintable{126};
+  if (ch.rune < FirstPrintable or ch.rune > LastPrintable) {
+    return false;
+  }
+  auto changed{0};
+  for (Dim line = area.y1(); line < area.y2(); ++line) {
+    changed += int(std::count_if(
+      text_.data[line].begin() + area.x1(),
+      text_.data[line].begin() + area.x2(),
+      [&ch](const Char &current) {return current != ch;}
+    ));
+  }
+  if (changed < MinFillCells) {
+    return false;
+  }
+  const auto screenArea{area + position_};
+  foreground(ch.attributes.fg);
+  background(ch.attributes.bg);
+  attributes(ch.attributes.attr);
+  if (ch == Space) {
+    write(format("\x1b[{};{};{};{}$z", screenArea.y1() + 1, screenArea.x1() + 1, screenArea.y2(), screenArea.x2()));
+  } else {
+    write(
+      format(
+        "\x1b[{};{};{};{};{}$x",
+        int(ch.rune),
+        screenArea.y1() + 1,
+        screenArea.x1() + 1,
+        screenArea.y2(),
+        screenArea.x2()
+      )
+    );
+  }
+  for (Dim line = area.y1(); line < area.y2(); ++line) {
+    std::fill(text_.data[line].begin() + area.x1(), text_.data[line].begin() + area.x2(), ch);
+  }
+  return true;
+}
+
 auto Display::size() const -> Vector {
   return text_.size();
 }
@@ -239,4 +410,50 @@ void Display::mouseMode(MouseMode mode) const {
   write(sequence[static_cast<int>(mode)]); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 }
 
+auto Display::keyboardProtocol(bool enable) -> bool {
+  static const basic_regex reportPattern("\x1b\\[\\?\\d+u");
+  if (enable != keyboard_.kittyProtocol()) {
+    if (enable) {
+      // Query protocol flags, then primary device attributes, which all terminals answer
+      write("\x1b[?u\x1b[c");
+      if (regex_search(report('c'), reportPattern)) {
+        write("\x1b[>1u");
+        keyboard_.kittyProtocol(true);
+      }
+    } else {
+      write("\x1b[<u");
+      keyboard_.kittyProtocol(false);
+    }
+  }
+  return keyboard_.kittyProtocol();
+}
+
+auto Display::rectangularEditing(bool enable) -> bool {
+  static const basic_regex attributePattern("\\d+");
+  if (enable and !rectangular_) {
+    write("\x1b[c");
+    const auto attributes{report('c')};
+    // The first parameter is the terminal class, the others are features
+    const auto features{attributes.find(';')};
+    if (features != string::npos) {
+      for (sregex_iterator match{attributes.begin() + long(features), attributes.end(), attributePattern}; match != sregex_iterator{}; ++match) {
+        rectangular_ = rectangular_ or stoi(match->str()) == RectangularEditing;
+      }
+    }
+  } else if (!enable) {
+    rectangular_ = false;
+  }
+  return rectangular_;
+}
+
+auto Display::report(char final) -> string {
+  string result;
+  Unicode key{0};
+  do {
+    key = keyboard_.key();
+    result += static_cast<string::value_type>(key);
+  } while (key != Unicode(final));
+  return result;
+}
+
 } // namespace jwezel
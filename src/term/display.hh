@@ -111,6 +111,32 @@ struct Display: Device {
   /// @param[in]  updates  The updates
   void update(const Updates &updates) override;
 
+  ///
+  /// Move screen content
+  ///
+  /// Moved content is taken from the screen image, so it does not need to be
+  /// composited again. With rectangular editing enabled, the terminal copies
+  /// the areas itself (DECCRA). Areas spanning whole lines are scrolled,
+  /// others are written like any update.
+  ///
+  /// @param[in]  areas   The areas
+  /// @param[in]  offset  The offset
+  ///
+  /// @return     False if an area or its destination is not on screen
+  auto move(const vector<Rectangle> &areas, const Vector &offset) -> bool override;
+
+  ///
+  /// Fill area with character
+  ///
+  /// Cells differing from the character are written like any update, or the
+  /// area is filled at once with rectangular editing enabled.
+  ///
+  /// @param[in]  area  The area
+  /// @param[in]  ch    The character
+  ///
+  /// @return     True
+  auto fill(const Rectangle &area, const Char &ch) -> bool override;
+
   ///
   /// Get terminal size
   ///
@@ -118,6 +144,8 @@ struct Display: Device {
   ///
   [[nodiscard]] auto size() const -> Vector;
 
+  [[nodiscard]] auto area() const -> Rectangle override {return Rectangle{Vector{0, 0}, size()};}
+
   ///
   /// Set terminal size
   ///
@@ -130,11 +158,77 @@ struct Display: Device {
 
   void mouseMode(MouseMode mode) const;
 
+  ///
+  /// Turn kitty keyboard protocol on/off
+  ///
+  /// Enabling queries the terminal and requests disambiguated key reports
+  /// (`CSI > 1 u`) only if the terminal supports the protocol.
+  ///
+  /// @param[in]  enable  Whether to enable the protocol
+  ///
+  /// @return     Whether the protocol is active
+  auto keyboardProtocol(bool enable) -> bool;
+
+  ///
+  /// Turn rectangular area operations on/off
+  ///
+  /// Enabling queries the primary device attributes and uses the VT420
+  /// rectangular editing sequences (DECCRA, DECFRA, DECERA) only if the
+  /// terminal reports supporting them.
+  ///
+  /// @param[in]  enable  Whether to enable rectangular editing
+  ///
+  /// @return     Whether rectangular editing is active
+  auto rectangularEditing(bool enable) -> bool;
+
   [[nodiscard]] auto maxSize() const {return maxSize_;}
 
   [[nodiscard]] auto text() const {return text_;}
 
+  ///
+  /// Get number of bytes written to the terminal
+  [[nodiscard]] auto written() const {return written_;}
+
   private:
+  ///
+  /// Read terminal report
+  ///
+  /// @param[in]  final  The final character of the report
+  ///
+  /// @return     The report
+  auto report(char final) -> string;
+
+  ///
+  /// Fill area with character using DECFRA or DECERA
+  ///
+  /// Only done if the character can be sent that way and enough cells change
+  /// to make up for the sequence.
+  ///
+  /// @param[in]  area  The area
+  /// @param[in]  ch    The character
+  ///
+  /// @return     Whether the area was filled
+  auto rectangularFill(const Rectangle &area, const Char &ch) -> bool;
+
+  ///
+  /// Move area vertically by scrolling the lines it spans
+  ///
+  /// Only possible for areas spanning the whole terminal width.
+  ///
+  /// @param[in]  area    The area
+  /// @param[in]  offset  The offset
+  ///
+  /// @return     Whether the area was scrolled
+  auto scroll(const Rectangle &area, const Vector &offset) -> bool;
+
+  ///
+  /// Write character to screen unless it is there already
+  ///
+  /// @param[in]  column  The column
+  /// @param[in]  line    The line
+  /// @param[in]  ch      The character
+  void put(Dim column, Dim line, const Char &ch);
+
   Keyboard &keyboard_;                //< Keyboard
   int output_;                        //< Output file descriptor
   Vector cursor_;                     //< Current cursor position
@@ -145,6 +239,8 @@ struct Display: Device {
   Vector position_;                   //< Display position
   Vector maxSize_;                    //< Maximum display size
   Text text_;                         //< Display text
+  mutable size_t written_{0};         //< Bytes written to output
+  bool rectangular_{false};           //< Rectangular editing enabled
 };
 
 } // namespace jwezel
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <util/xxh64.hpp>
 
@@ -67,8 +68,23 @@ struct Event {
     return event_->typeName();
   }
 
+  ///
+  /// Get time the event was received
+  [[nodiscard]] auto time() const -> std::chrono::steady_clock::time_point {
+    return time_;
+  }
+
+  ///
+  /// Set time the event was received
+  ///
+  /// @param[in]  time  The time
+  void time(std::chrono::steady_clock::time_point time) {
+    time_ = time;
+  }
+
   private:
   std::unique_ptr<BaseEvent> event_;
+  std::chrono::steady_clock::time_point time_{}; //< Time received
 };
 
 } // namespace jwezel
@@ -0,0 +1,345 @@
+#include "file.hh"
+#include "geometry.hh"
+#include "region.hh"
+#include "surface.hh"
+#include "text.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+#include <utf8cpp/utf8.h>
+
+namespace jwezel {
+
+using std::format, std::out_of_range, std::string_view, std::system_category, std::system_error;
+
+namespace {
+
+const Unicode ReplacementRune{0xfffd};
+
+///
+/// Decode line
+///
+/// Tabs are expanded and control characters replaced.
+///
+/// @param[in]  bytes    The bytes of the line
+/// @param[in]  columns  Number of columns needed
+///
+/// @return     Characters of the columns the line reaches
+auto decode(string_view bytes, Dim columns) -> String {
+  // No character takes more than 4 bytes, so the rest is never shown
+  bytes = bytes.substr(0, std::min(bytes.size(), size_t(columns) * 4 + 4));
+  string valid;
+  if (!utf8::is_valid(bytes.begin(), bytes.end())) {
+    utf8::replace_invalid(bytes.begin(), bytes.end(), back_inserter(valid));
+    bytes = valid;
+  }
+  String result;
+  auto position{bytes.begin()};
+  while (position != bytes.end() and result.size() < size_t(columns)) {
+    const auto rune{Unicode(utf8::next(position, bytes.end()))};
+    if (rune == '\t') {
+      const auto tab{size_t(FileElement::TabSize)};
+      result.resize(std::min(size_t(columns), (result.size() / tab + 1) * tab), Space);
+    } else if (rune < ' ' or rune == 0x7f) {
+      result.emplace_back(ReplacementRune);
+    } else {
+      result.emplace_back(rune);
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+FileElement::FileElement(
+  Surface *surface,
+  const Rectangle &area,
+  const string &path,
+  const Char &background,
+  Surface::Element *below
+):
+Element{surface},
+area_{area},
+background_{background},
+fd_{::open(path.c_str(), O_RDONLY | O_CLOEXEC)}
+{
+  if (fd_ < 0) {
+    throw system_error(errno, system_category(), format("Could not open {}", path));
+  }
+  try {
+    map(fileSize());
+  } catch (...) {
+    ::close(fd_);
+    throw;
+  }
+  prepare(size_t(area_.height()));
+  surface->addElement(this, below);
+  index();
+  shown_ = lines();
+}
+
+FileElement::~FileElement() {
+  stopping_ = true;
+  if (indexer_.joinable()) {
+    indexer_.join();
+  }
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+  ::close(fd_);
+  try {
+    surface()->deleteElement(this);
+  } catch (std::exception & error) {
+    std::cerr << error.what() << '\n';
+  }
+}
+
+auto FileElement::refresh() -> bool {
+  const auto size{fileSize()};
+  const auto shrunk{size < size_};
+  const auto changed{size != size_};
+  if (changed) {
+    std::lock_guard lock{mutex_};
+    if (shrunk) {
+      checkpoints_ = {0};
+      newlines_ = 0;
+      scanned_ = 0;
+    }
+    map(size);
+  }
+  prepare(top_ + size_t(area_.height()));
+  // Also resumes indexing of what the indexer had not seen when it stopped
+  index();
+  const auto lines_{lines()};
+  if (shrunk) {
+    shown_ = lines_;
+    top_ = follow_? bottom(): std::min(top_, lines_ > 0? lines_ - 1: 0);
+    update(Region(Rectangle{Vector{0, 0}, area_.size()}));
+    return true;
+  }
+  if (!changed and lines_ == shown_) {
+    return false;
+  }
+  // The last line known before may have been incomplete
+  const auto from{shown_ > 0? shown_ - 1: 0};
+  shown_ = lines_;
+  if (follow_ and scrollTo(bottom())) {
+    return true;
+  }
+  const auto first{std::max(from, top_)}, last{std::min(lines_, top_ + size_t(area_.height()))};
+  if (first < last) {
+    update(Region(Rectangle{0, Dim(first - top_), area_.width(), Dim(last - top_)}));
+  }
+  return true;
+}
+
+auto FileElement::lines() const -> size_t {
+  std::lock_guard lock{mutex_};
+  return linesIndexed();
+}
+
+auto FileElement::indexed() const -> bool {
+  std::lock_guard lock{mutex_};
+  return scanned_ == size_;
+}
+
+auto FileElement::line(size_t number) const -> string_view {
+  std::lock_guard lock{mutex_};
+  if (number >= linesIndexed()) {
+    throw out_of_range(format("Line {} is not indexed ({} lines)", number, linesIndexed()));
+  }
+  return find(number);
+}
+
+void FileElement::top(size_t number) {
+  follow_ = false;
+  prepare(number + size_t(area_.height()));
+  const auto lines_{lines()};
+  (void)scrollTo(std::min(number, lines_ > 0? lines_ - 1: 0));
+}
+
+void FileElement::follow(bool follow) {
+  follow_ = follow;
+  if (follow) {
+    index();
+    (void)scrollTo(bottom());
+  }
+}
+
+void FileElement::styler(Styler styler) {
+  styler_ = std::move(styler);
+  update(Region(Rectangle{Vector{0, 0}, area_.size()}));
+}
+
+auto FileElement::moveEvent(const Rectangle &area) -> bool {
+  area_ = area;
+  prepare(top_ + size_t(area_.height()));
+  if (follow_) {
+    top_ = bottom();
+  }
+  return true;
+}
+
+auto FileElement::text(const Rectangle &area) const -> Text {
+  const auto visible{area & Rectangle{Vector{0, 0}, area_.size()}};
+  Text result;
+  if (!visible) {
+    return result;
+  }
+  result.data.reserve(visible->height());
+  size_t lines_{0};
+  {
+    std::lock_guard lock{mutex_};
+    lines_ = linesIndexed();
+    for (auto row = visible->y1(); row < visible->y2(); ++row) {
+      const auto number{top_ + size_t(row)};
+      result.data.push_back(number < lines_? decode(find(number), visible->x2()): String{});
+    }
+  }
+  for (auto row = visible->y1(); row < visible->y2(); ++row) {
+    auto &line_{result.data[size_t(row - visible->y1())]};
+    const auto number{top_ + size_t(row)};
+    if (styler_ and number < lines_) {
+      styler_(number, line_);
+    }
+    line_.erase(line_.begin(), line_.begin() + std::min(line_.size(), size_t(visible->x1())));
+    line_.resize(size_t(visible->width()), background_);
+  }
+  return result;
+}
+
+auto FileElement::fileSize() const -> size_t {
+  struct stat status{};
+  if (::fstat(fd_, &status) < 0) {
+    throw system_error(errno, system_category(), format("Could not get size of file {}", fd_));
+  }
+  return size_t(status.st_size);
+}
+
+void FileElement::map(size_t size) {
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+  if (size > 0) {
+    auto *data{::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0)};
+    if (data == MAP_FAILED) {
+      throw system_error(errno, system_category(), format("Could not map file {}", fd_));
+    }
+    data_ = static_cast<const char *>(data);
+    size_ = size;
+  }
+}
+
+void FileElement::scan() {
+  const auto *position{data_ + scanned_};
+  const auto *end{data_ + std::min(size_, scanned_ + ChunkSize)};
+  while (position != end) {
+    const auto *newline{static_cast<const char *>(std::memchr(position, '\n', size_t(end - position)))};
+    if (!newline) {
+      break;
+    }
+    position = newline + 1;
+    if (++newlines_ % CheckpointLines == 0) {
+      checkpoints_.push_back(size_t(position - data_));
+    }
+  }
+  scanned_ = size_t(end - data_);
+}
+
+void FileElement::prepare(size_t lines) {
+  std::lock_guard lock{mutex_};
+  while (scanned_ < size_ and newlines_ < lines) {
+    scan();
+  }
+}
+
+void FileElement::index() {
+  auto large{false};
+  {
+    std::lock_guard lock{mutex_};
+    large = size_ - scanned_ > BackgroundSize;
+  }
+  if (large or indexing_) {
+    indexInBackground();
+  } else {
+    prepare(std::numeric_limits<size_t>::max());
+  }
+}
+
+void FileElement::indexInBackground() {
+  if (indexing_) {
+    return;
+  }
+  if (indexer_.joinable()) {
+    indexer_.join();
+  }
+  indexing_ = true;
+  indexer_ = std::thread([this]() {
+    while (true) {
+      std::lock_guard lock{mutex_};
+      // Cleared under the lock, so refresh() sees the indexer running until all is scanned
+      if (stopping_ or scanned_ == size_) {
+        indexing_ = false;
+        break;
+      }
+      scan();
+    }
+  });
+}
+
+auto FileElement::linesIndexed() const -> size_t {
+  return newlines_ + (scanned_ == size_ and size_ > 0 and data_[size_ - 1] != '\n');
+}
+
+auto FileElement::find(size_t number) const -> string_view {
+  const auto *position{data_ + checkpoints_[number / CheckpointLines]};
+  const auto *end{data_ + size_};
+  for (auto skip = number % CheckpointLines; skip > 0; --skip) {
+    position = static_cast<const char *>(std::memchr(position, '\n', size_t(end - position))) + 1;
+  }
+  const auto *newline{static_cast<const char *>(std::memchr(position, '\n', size_t(end - position)))};
+  auto length{size_t((newline? newline: end) - position)};
+  if (length > 0 and position[length - 1] == '\r') {
+    --length;
+  }
+  return string_view{position, length};
+}
+
+auto FileElement::scrollTo(size_t number) -> bool {
+  if (number == top_) {
+    return false;
+  }
+  const auto previousTop{top_};
+  const auto distance{number > top_? number - top_: top_ - number};
+  top_ = number;
+  const Rectangle all{Vector{0, 0}, area_.size()};
+  if (distance < size_t(area_.height())) {
+    shift(all, Vector{0, number > previousTop? Dim(-Dim(distance)): Dim(distance)});
+    return false;
+  }
+  update(Region(all));
+  return true;
+}
+
+auto FileElement::bottom() const -> size_t {
+  const auto height{size_t(area_.height())}, lines_{lines()};
+  return lines_ > height? lines_ - height: 0;
+}
+
+} // namespace jwezel
@@ -0,0 +1,233 @@
+///
+/// @defgroup   FILE file
+///
+/// This file defines an element showing a memory-mapped file.
+
+#pragma once
+
+#include "geometry.hh"
+#include "surface.hh"
+#include "text.hh"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace jwezel {
+
+///
+/// View of a text file
+///
+/// The file is mapped into memory and never read as a whole. Line starts are
+/// indexed as far as the view needs them, large files on a background thread.
+/// Only every CheckpointLines-th line start is kept, so that the index stays
+/// small. Visible lines are decoded when rendered.
+///
+/// refresh() picks up lines appended to the file and progress of the
+/// background indexing. The file must not shrink except between refreshes, as
+/// accessing mapped pages beyond its end raises SIGBUS.
+struct FileElement: Surface::Element {
+  ///
+  /// Distance of indexed line starts
+  static constexpr size_t CheckpointLines{256};
+
+  ///
+  /// Files larger than this are indexed on a background thread
+  static constexpr size_t BackgroundSize{size_t{16} << 20U};
+
+  ///
+  /// Bytes indexed at once
+  static constexpr size_t ChunkSize{size_t{1} << 20U};
+
+  ///
+  /// Columns of a tab stop
+  static constexpr Dim TabSize{8};
+
+  ///
+  /// Function styling a rendered line
+  ///
+  /// Gets the line number and the characters of the line up to the last
+  /// column shown.
+  using Styler = std::function<void(size_t number, String &line)>;
+
+  ///
+  /// Constructor
+  ///
+  /// Throws system_error if the file cannot be opened or mapped.
+  ///
+  /// @param[in]  surface     The surface
+  /// @param[in]  area        The area
+  /// @param[in]  path        The file path
+  /// @param[in]  background  The background
+  /// @param[in]  below       The element to insert below
+  explicit FileElement(
+    Surface *surface,
+    const Rectangle &area,
+    const string &path,
+    const Char &background=Space,
+    Surface::Element *below=0
+  );
+
+  FileElement(const FileElement &) = delete;
+
+  FileElement(FileElement &&) = delete;
+
+  auto operator=(const FileElement &) -> FileElement & = delete;
+
+  auto operator=(FileElement &&) -> FileElement & = delete;
+
+  ///
+  /// Destroy FileElement
+  ~FileElement() override;
+
+  ///
+  /// Pick up file growth and indexing progress
+  ///
+  /// A file shrunk is indexed anew. Following views scroll to the end of the
+  /// file.
+  ///
+  /// @return     True if the file or the lines known changed
+  auto refresh() -> bool;
+
+  ///
+  /// Get number of lines indexed
+  ///
+  /// @return     Number of lines
+  [[nodiscard]] auto lines() const -> size_t;
+
+  ///
+  /// Determine whether the whole file is indexed
+  ///
+  /// @return     True if indexing is complete
+  [[nodiscard]] auto indexed() const -> bool;
+
+  ///
+  /// Get line
+  ///
+  /// Throws out_of_range if the line is not indexed.
+  ///
+  /// @param[in]  number  The line number
+  ///
+  /// @return     Bytes of the line without line end, valid until the file is remapped
+  [[nodiscard]] auto line(size_t number) const -> std::string_view;
+
+  ///
+  /// Get number of the line shown at the top
+  [[nodiscard]] inline auto top() const {return top_;}
+
+  ///
+  /// Show line at the top
+  ///
+  /// Stops following the end of the file.
+  ///
+  /// @param[in]  number  The line number
+  void top(size_t number);
+
+  ///
+  /// Turn following the end of the file on/off
+  ///
+  /// @param[in]  follow  Whether to follow
+  void follow(bool follow);
+
+  [[nodiscard]] inline auto follow() const {return follow_;}
+
+  ///
+  /// Set function styling visible lines
+  ///
+  /// @param[in]  styler  The styler
+  void styler(Styler styler);
+
+  [[nodiscard]] auto area() const -> Rectangle override {return area_;}
+
+  auto moveEvent(const Rectangle &area) -> bool override;
+
+  ///
+  /// Render visible lines
+  ///
+  /// @param[in]  area  The area
+  ///
+  /// @return     text
+  [[nodiscard]] auto text(const Rectangle &area=RectangleMax) const -> Text override;
+
+  private:
+  ///
+  /// Get size of the file
+  [[nodiscard]] auto fileSize() const -> size_t;
+
+  ///
+  /// Map file
+  ///
+  /// @param[in]  size  The file size
+  void map(size_t size);
+
+  ///
+  /// Index next chunk of the file
+  ///
+  /// Must be called with mutex_ held.
+  void scan();
+
+  ///
+  /// Index file until number of lines are known or the file ends
+  ///
+  /// @param[in]  lines  Number of lines
+  void prepare(size_t lines);
+
+  ///
+  /// Index rest of the file, on a background thread if large
+  void index();
+
+  ///
+  /// Start indexing on a background thread, unless already running
+  void indexInBackground();
+
+  ///
+  /// Get number of lines indexed
+  ///
+  /// Must be called with mutex_ held.
+  [[nodiscard]] auto linesIndexed() const -> size_t;
+
+  ///
+  /// Get bytes of line
+  ///
+  /// Must be called with mutex_ held.
+  ///
+  /// @param[in]  number  The line number, which must be indexed
+  ///
+  /// @return     Bytes of the line without line end
+  [[nodiscard]] auto find(size_t number) const -> std::string_view;
+
+  ///
+  /// Show line at the top, updating what changed
+  ///
+  /// @param[in]  number  The line number
+  ///
+  /// @return     Whether the whole element was updated
+  auto scrollTo(size_t number) -> bool;
+
+  ///
+  /// Get number of the top line showing the last line at the bottom
+  [[nodiscard]] auto bottom() const -> size_t;
+
+  Rectangle area_;
+  Char background_;
+  Styler styler_;
+  int fd_{-1};                        //< File descriptor
+  const char *data_{nullptr};         //< Mapped file
+  size_t size_{0};                    //< Mapped size
+  vector<size_t> checkpoints_{0};     //< Start of every CheckpointLines-th line
+  size_t newlines_{0};                //< Line ends found
+  size_t scanned_{0};                 //< Bytes indexed
+  size_t shown_{0};                   //< Lines known when the view was last updated
+  size_t top_{0};                     //< Number of the line shown at the top
+  bool follow_{false};                //< Whether the last line is kept at the bottom
+  mutable std::mutex mutex_;          //< Guards mapping and index against the indexer
+  std::thread indexer_;               //< Background indexer
+  std::atomic<bool> indexing_{false}; //< Whether the indexer is running
+  std::atomic<bool> stopping_{false}; //< Whether the indexer is to stop
+};
+
+} // namespace jwezel
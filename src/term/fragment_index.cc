@@ -0,0 +1,154 @@
+#include "fragment_index.hh"
+#include "geometry.hh"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry.hpp>
+
+namespace jwezel {
+
+using std::format, std::pair;
+
+//~RtreeIndex~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void RtreeIndex::insert(const Rectangle &area, FragmentHandle handle) {
+  rtree_.insert(Entry{area, handle});
+}
+
+void RtreeIndex::remove(const Rectangle &area, FragmentHandle handle) {
+  rtree_.remove(Entry{area, handle});
+}
+
+auto RtreeIndex::find(const Vector &position) const -> optional<FragmentHandle> {
+  vector<Entry> result;
+  rtree_.query(boost::geometry::index::contains(Rectangle{position, position + Vector{1, 1}}), std::back_inserter(result));
+  switch (result.size()) {
+    case 0:
+    return {};
+
+    case 1:
+    return result[0].second;
+
+    default:
+    throw std::logic_error(format("Found {} results. Expected only one", result.size()));
+  }
+}
+
+auto RtreeIndex::find(const Rectangle &area) const -> vector<FragmentHandle> {
+  vector<Entry> entries;
+  // Boxes touching the area count as intersecting in boost
+  rtree_.query(
+    boost::geometry::index::intersects(area) and
+    boost::geometry::index::satisfies([&area](const Entry &entry) {return entry.first.intersects(area);}),
+    std::back_inserter(entries)
+  );
+  vector<FragmentHandle> result;
+  result.reserve(entries.size());
+  for (const auto &[_, handle]: entries) {
+    result.push_back(handle);
+  }
+  return result;
+}
+
+//~GridIndex~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void GridIndex::insert(const Rectangle &area, FragmentHandle handle) {
+  extend(area);
+  if (handle >= areas_.size()) {
+    areas_.resize(handle + 1);
+  }
+  areas_[handle] = area;
+  ++size_;
+  place(area, handle);
+}
+
+void GridIndex::remove(const Rectangle &area, FragmentHandle handle) {
+  if (handle >= areas_.size() or areas_[handle] != area) {
+    return;
+  }
+  const auto [first, end]{rows(area)};
+  for (auto row = first; row < end; ++row) {
+    auto &intervals{rows_[row]};
+    const auto candidates{std::ranges::equal_range(intervals, area.x1(), {}, &Interval::x1)};
+    const auto interval{std::ranges::find(candidates, handle, &Interval::handle)};
+    if (interval != candidates.end()) {
+      intervals.erase(interval);
+    }
+  }
+  areas_[handle].reset();
+  --size_;
+}
+
+auto GridIndex::find(const Vector &position) const -> optional<FragmentHandle> {
+  const auto &intervals{rows_[std::clamp(int(position.y()) - top_, 0, int(rows_.size()) - 1)]};
+  const auto next{std::ranges::upper_bound(intervals, position.x(), {}, &Interval::x1)};
+  if (next == intervals.begin() or position.x() >= std::prev(next)->x2) {
+    return {};
+  }
+  return std::prev(next)->handle;
+}
+
+auto GridIndex::find(const Rectangle &area) const -> vector<FragmentHandle> {
+  vector<FragmentHandle> result;
+  if (area.y1() >= area.y2()) {
+    return result;
+  }
+  // Unlike rows(), areas beyond the rows find the first or last one
+  const auto row{[this](int y) {return size_t(std::clamp(y - top_, 0, int(rows_.size()) - 1));}};
+  for (auto index = row(area.y1()); index <= row(area.y2() - 1); ++index) {
+    for (const auto &interval: rows_[index]) {
+      if (interval.x1 >= area.x2()) {
+        break;
+      }
+      // The first and last row stand for several rows
+      if (interval.x2 > area.x1() and areas_[interval.handle]->intersects(area)) {
+        result.push_back(interval.handle);
+      }
+    }
+  }
+  // Fragments crossing several rows are found in each
+  std::ranges::sort(result);
+  const auto duplicates{std::ranges::unique(result)};
+  result.erase(duplicates.begin(), duplicates.end());
+  return result;
+}
+
+auto GridIndex::rows(const Rectangle &area) const -> pair<size_t, size_t> {
+  const auto row{[this](Dim y) {return size_t(std::clamp(int(y) - top_, 0, int(rows_.size()) - 1));}};
+  return {
+    area.y1() == DimLow? 0: row(area.y1()),
+    area.y2() == DimHigh? rows_.size(): row(area.y2())
+  };
+}
+
+void GridIndex::place(const Rectangle &area, FragmentHandle handle) {
+  const auto [first, end]{rows(area)};
+  for (auto row = first; row < end; ++row) {
+    auto &intervals{rows_[row]};
+    intervals.insert(std::ranges::upper_bound(intervals, area.x1(), {}, &Interval::x1), Interval{area.x1(), area.x2(), handle});
+  }
+}
+
+void GridIndex::extend(const Rectangle &area) {
+  // Bounded top edges must lie below the first row, bounded bottom edges above the last one
+  const auto bottom{int(top_) + int(rows_.size()) - 1};
+  const auto top{area.y1() == DimLow? int(top_): std::min(int(top_), area.y1() - 1)};
+  const auto newBottom{area.y2() == DimHigh? bottom: std::max(bottom, int(area.y2()))};
+  if (top == top_ and newBottom == bottom) {
+    return;
+  }
+  top_ = Dim(top);
+  rows_.assign(newBottom - top + 1, Row{});
+  for (FragmentHandle handle = 0; handle < areas_.size(); ++handle) {
+    if (areas_[handle]) {
+      place(areas_[handle].value(), handle);
+    }
+  }
+}
+
+} // namespace jwezel
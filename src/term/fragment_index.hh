@@ -0,0 +1,164 @@
+///
+/// @defgroup   FRAGMENT_INDEX fragment_index
+///
+/// This file defines spatial indexes of surface fragments.
+
+#pragma once
+
+#include "geometry.hh"
+
+#include <util/basic.hh>
+
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/register/box.hpp>
+#include <boost/geometry/geometries/register/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// NOLINTBEGIN
+BOOST_GEOMETRY_REGISTER_POINT_2D(jwezel::Vector, jwezel::Dim, cs::cartesian, x(), y());
+BOOST_GEOMETRY_REGISTER_BOX_2D_4VALUES(jwezel::Rectangle, jwezel::Vector, x1(), y1(), x2(), y2());
+// NOLINTEND
+
+const auto maxRtreeElements = 16;
+const auto minRtreeElements = 4;
+
+namespace jwezel {
+
+///
+/// Index of a fragment in the fragment pool of a surface
+using FragmentHandle = u4;
+
+///
+/// Spatial index of fragments
+///
+/// Fragments of a surface do not overlap once a change of the surface is
+/// complete, but may do so while fragments are being replaced.
+struct FragmentIndex {
+  FragmentIndex() = default;
+
+  virtual ~FragmentIndex() = default;
+
+  FragmentIndex(const FragmentIndex &) = delete;
+
+  FragmentIndex(FragmentIndex &&) = delete;
+
+  auto operator=(const FragmentIndex &) -> FragmentIndex & = delete;
+
+  auto operator=(FragmentIndex &&) -> FragmentIndex & = delete;
+
+  ///
+  /// Add fragment
+  ///
+  /// @param[in]  area    The area of the fragment
+  /// @param[in]  handle  The fragment
+  virtual void insert(const Rectangle &area, FragmentHandle handle) = 0;
+
+  ///
+  /// Remove fragment
+  ///
+  /// @param[in]  area    The area the fragment was added with
+  /// @param[in]  handle  The fragment
+  virtual void remove(const Rectangle &area, FragmentHandle handle) = 0;
+
+  ///
+  /// Find fragment containing position
+  ///
+  /// @param[in]  position  The position
+  ///
+  /// @return     The fragment, if any
+  [[nodiscard]] virtual auto find(const Vector &position) const -> optional<FragmentHandle> = 0;
+
+  ///
+  /// Find fragments intersecting area
+  ///
+  /// @param[in]  area  The area
+  ///
+  /// @return     The fragments, each once
+  [[nodiscard]] virtual auto find(const Rectangle &area) const -> vector<FragmentHandle> = 0;
+
+  ///
+  /// Get number of fragments
+  ///
+  /// @return     Number of fragments
+  [[nodiscard]] virtual auto size() const -> size_t = 0;
+};
+
+///
+/// Fragment index based on a boost R-tree
+struct RtreeIndex final: FragmentIndex {
+  void insert(const Rectangle &area, FragmentHandle handle) override;
+
+  void remove(const Rectangle &area, FragmentHandle handle) override;
+
+  [[nodiscard]] auto find(const Vector &position) const -> optional<FragmentHandle> override;
+
+  [[nodiscard]] auto find(const Rectangle &area) const -> vector<FragmentHandle> override;
+
+  [[nodiscard]] auto size() const -> size_t override {return rtree_.size();}
+
+  private:
+  using Entry = std::pair<Rectangle, FragmentHandle>;
+
+  boost::geometry::index::rtree<Entry, boost::geometry::index::quadratic<maxRtreeElements, minRtreeElements>> rtree_;
+};
+
+///
+/// Fragment index based on a uniform grid of rows
+///
+/// Each row holds the fragments crossing it ordered by left edge. Rows exist
+/// between the lowest top and highest bottom edge of all fragments. The first
+/// row stands for all rows above, the last one for all rows below, as only
+/// fragments unbounded upwards or downwards reach them.
+struct GridIndex final: FragmentIndex {
+  void insert(const Rectangle &area, FragmentHandle handle) override;
+
+  void remove(const Rectangle &area, FragmentHandle handle) override;
+
+  [[nodiscard]] auto find(const Vector &position) const -> optional<FragmentHandle> override;
+
+  [[nodiscard]] auto find(const Rectangle &area) const -> vector<FragmentHandle> override;
+
+  [[nodiscard]] auto size() const -> size_t override {return size_;}
+
+  private:
+  struct Interval {
+    Dim x1;
+    Dim x2;
+    FragmentHandle handle;
+  };
+
+  using Row = vector<Interval>;
+
+  ///
+  /// Get rows crossed by area
+  ///
+  /// @param[in]  area  The area
+  ///
+  /// @return     First and end row index
+  [[nodiscard]] auto rows(const Rectangle &area) const -> std::pair<size_t, size_t>;
+
+  ///
+  /// Add fragment to the rows it crosses
+  ///
+  /// @param[in]  area    The area of the fragment
+  /// @param[in]  handle  The fragment
+  void place(const Rectangle &area, FragmentHandle handle);
+
+  ///
+  /// Add rows so that the edges of area lie between the first and last row,
+  /// redistributing all fragments if necessary
+  ///
+  /// @param[in]  area  The area
+  void extend(const Rectangle &area);
+
+  vector<Row> rows_{Row{}};           //< Rows, the first standing for y <= top_
+  vector<optional<Rectangle>> areas_; //< Areas of fragments by handle
+  Dim top_{0};                        //< Row above all bounded top edges
+  size_t size_{0};                    //< Number of fragments
+};
+
+} // namespace jwezel
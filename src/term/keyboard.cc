@@ -1,13 +1,18 @@
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <poll.h>
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <termios.h>
 #include <thread>
@@ -21,22 +26,27 @@
 
 namespace jwezel {
 using
+  std::array,
+  std::map,
+  std::nullopt,
+  std::optional,
+  std::u32string_view,
   std::basic_regex,
   std::cerr,
   std::chrono::steady_clock,
   std::format,
-  std::make_pair,
   std::pair,
   std::runtime_error,
   std::smatch,
   std::strerror,
+  std::string_view,
   std::this_thread::sleep_for,
   std::u32string;
 using namespace std::chrono_literals;
 
 namespace
 {
-const vector<pair<string, Unicode>> KeyFromName { // NOLINT(cert-err58-cpp)
+constexpr auto KeyFromName{std::to_array<pair<string_view, Unicode>>({
   {"Left", Key::Left},
   {"Right", Key::Right},
   {"Up", Key::Up},
@@ -162,9 +172,9 @@ const vector<pair<string, Unicode>> KeyFromName { // NOLINT(cert-err58-cpp)
   {"AltF10", Key::AltF10},
   {"AltF11", Key::AltF11},
   {"AltF12", Key::AltF12}
-};
+})};
 
-const std::vector<pair<std::string, Unicode>> keyTranslations { // NOLINT(cert-err58-cpp)
+constexpr auto KeyTranslations{std::to_array<pair<string_view, Unicode>>({
   {"\x1b[D", Key::Left},
   {"\x1b[C", Key::Right},
   {"\x1b[A", Key::Up},
@@ -292,7 +302,7 @@ const std::vector<pair<std::string, Unicode>> keyTranslations { // NOLINT(cert-e
   {"\x1b\x1b[23~", Key::AltF11},
   {"\x1b\x1b[24~", Key::AltF12},
   {"\x1b[<", Key::Mouse}
-};
+})};
 } // namespace
 
 //~Static functions~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -300,37 +310,284 @@ const std::vector<pair<std::string, Unicode>> keyTranslations { // NOLINT(cert-e
 namespace
 {
 ///
-/// Load key translations
+/// Get all prefixes of key sequences in prefix tree order
+///
+/// Ordered by length, then bytes: the children of every node are adjacent and
+/// follow the children of the preceding node.
+///
+/// @param[in]  translations  The key translations
+///
+/// @return     Prefixes, the empty root prefix first
+constexpr auto sequencePrefixes(const auto &translations) -> vector<string_view> {
+  vector<string_view> result;
+  for (const auto &[sequence, key]: translations) {
+    for (size_t length = 0; length <= sequence.size(); ++length) {
+      result.push_back(sequence.substr(0, length));
+    }
+  }
+  const auto treeOrder{[](string_view lhs, string_view rhs) {
+    return lhs.size() < rhs.size() or lhs.size() == rhs.size() and lhs < rhs;
+  }};
+  std::ranges::sort(result, treeOrder);
+  const auto duplicates{std::ranges::unique(result)};
+  result.erase(duplicates.begin(), duplicates.end());
+  return result;
+}
+
+///
+/// Build key prefix tree
+///
+/// @param[in]  translations  The key translations (later ones win for equal sequences)
+///
+/// @tparam     Size          Number of nodes
+///
+/// @return     Prefix tree nodes
+template<size_t Size>
+constexpr auto prefixTreeNodes(const auto &translations) -> array<Keyboard::PrefixTree::Node, Size> {
+  static_assert(Size <= std::numeric_limits<u2>::max(), "Too many key prefixes");
+  const auto prefixes{sequencePrefixes(translations)};
+  array<Keyboard::PrefixTree::Node, Size> result{};
+  size_t child{1}; // Every prefix except the root is the child of the preceding shorter prefix
+  for (size_t index = 0; index < Size; ++index) {
+    const auto prefix{prefixes[index]};
+    auto &node{result[index]};
+    if (!prefix.empty()) {
+      node.byte = prefix.back();
+    }
+    for (const auto &[sequence, key]: translations) {
+      if (sequence == prefix) {
+        node.key = key;
+      }
+    }
+    node.children = static_cast<u2>(child);
+    while (child < Size and prefixes[child].size() == prefix.size() + 1 and prefixes[child].starts_with(prefix)) {
+      ++child;
+    }
+    node.childCount = static_cast<u2>(child - node.children);
+  }
+  return result;
+}
+
+constexpr auto KeyPrefixNodes{prefixTreeNodes<sequencePrefixes(KeyTranslations).size()>(KeyTranslations)};
+
+///
+/// Key modified by Shift, Ctrl, Ctrl+Shift and Alt
+struct ModifiedKey {
+  Unicode base;               //< Unmodified key
+  array<Unicode, 4> modified; //< Modified keys (base if there is none)
+};
+
 ///
-/// @param[in]  translations  The translations
+/// Build table of modified keys
 ///
-/// @return     key prefix tree
-auto loadKeyTranslations(const std::vector<pair<std::string, Unicode>> &translations) -> Keyboard::PrefixNode {
-  Keyboard::PrefixNode result;
-  for (const auto &[keys, key]: translations) {
-    Keyboard::PrefixNode *node{&result};
-    for (auto it = keys.begin(); it != keys.end(); ++it) {
-      auto elem = node->nodes.find(*it);
-      if (elem == node->nodes.end()) {
-        auto insResult = node->nodes.insert(make_pair(*it, new Keyboard::PrefixNode));
-        if (!insResult.second) {
-          throw runtime_error(format("Couldn't create keyboard translation tree node for \"{}\"", keys));
+/// Pairs every key name with the names prefixed by a modifier, e.g. Left with CtrlLeft.
+///
+/// @return     Modified keys ordered by base key
+constexpr auto modifiedKeys() -> array<ModifiedKey, KeyFromName.size()> {
+  const array<string_view, 4> prefixes{"Shift", "Ctrl", "CtrlShift", "Alt"};
+  array<ModifiedKey, KeyFromName.size()> result{};
+  for (size_t index = 0; index < KeyFromName.size(); ++index) {
+    const auto &[baseName, base]{KeyFromName[index]};
+    result[index].base = base;
+    for (size_t prefix = 0; prefix < prefixes.size(); ++prefix) {
+      result[index].modified[prefix] = base;
+      for (const auto &[name, key]: KeyFromName) {
+        if (name.size() == prefixes[prefix].size() + baseName.size() and name.starts_with(prefixes[prefix]) and name.ends_with(baseName)) {
+          result[index].modified[prefix] = key;
+          break;
         }
-        node = insResult.first->second.get();
-      } else {
-        node = elem->second.get();
       }
     }
-    node->key = key;
   }
+  std::ranges::sort(result, {}, &ModifiedKey::base);
   return result;
 }
+
+constexpr auto ModifiedKeys{modifiedKeys()};
+
+static_assert(
+  std::ranges::adjacent_find(ModifiedKeys, {}, &ModifiedKey::base) == ModifiedKeys.end(),
+  "Key names must name distinct keys"
+);
+
+const Unicode ReplacementRune{0xfffd};
+const size_t ReadBufferSize{4096};
+
+///
+/// Determine whether byte is a printable ASCII character
+///
+/// @param[in]  byte  The byte
+///
+/// @return     True if byte is in ' ' .. '~'
+inline auto isPrintableAscii(char byte) -> bool {
+  return byte >= ' ' and byte < '\x7f';
+}
+
+///
+/// Get length of run of printable ASCII characters at start of bytes
+///
+/// Examines eight bytes at a time and switches to single bytes when a word
+/// contains a control character, DEL or a non-ASCII byte.
+///
+/// @param[in]  bytes  The bytes
+///
+/// @return     Length of run
+auto printableAsciiLength(string_view bytes) -> size_t {
+  static const u8
+    Ones{0x0101010101010101ULL},
+    High{0x8080808080808080ULL};
+  size_t length{0};
+  for (; length + sizeof(u8) <= bytes.size(); length += sizeof(u8)) {
+    u8 word{0};
+    memcpy(&word, bytes.data() + length, sizeof word);
+    const u8 del{word ^ (Ones * '\x7f')};
+    // NOLINTBEGIN(hicpp-signed-bitwise)
+    if ((word & High) != 0 or ((word - Ones * ' ') & ~word & High) != 0 or ((del - Ones) & ~del & High) != 0) {
+      break;
+    }
+    // NOLINTEND(hicpp-signed-bitwise)
+  }
+  while (length < bytes.size() and isPrintableAscii(bytes[length])) {
+    ++length;
+  }
+  return length;
+}
+
+///
+/// Get key modified by modifiers
+///
+/// Looks up the combination in the key names, e.g. Ctrl + Left -> CtrlLeft.
+///
+/// @param[in]  base       The unmodified key
+/// @param[in]  modifiers  The modifiers
+///
+/// @return     Modified key, or @arg base if there is no such key
+auto modifiedKey(Unicode base, const KeyModifiers &modifiers) -> Unicode {
+  if (modifiers.super or modifiers.hyper or modifiers.meta or modifiers.alt and (modifiers.shift or modifiers.control)) {
+    return base;
+  }
+  if (!modifiers.shift and !modifiers.control and !modifiers.alt) {
+    return base;
+  }
+  const auto modifiedKey{std::ranges::lower_bound(ModifiedKeys, base, {}, &ModifiedKey::base)};
+  if (modifiedKey == ModifiedKeys.end() or modifiedKey->base != base) {
+    return base;
+  }
+  return modifiedKey->modified[modifiers.control? modifiers.shift? 2: 1: modifiers.shift? 0: 3];
+}
+
+///
+/// Decode control sequence reporting a key
+///
+/// Handles kitty keyboard protocol reports (`CSI code;modifiers u`) and
+/// modified legacy function keys (`CSI 1;modifiers A`, `CSI number;modifiers ~`).
+///
+/// @param[in]  sequence  The sequence including CSI and final byte
+///
+/// @return     Key and modifiers, if sequence could be decoded
+auto decodeCsi(const u32string &sequence) -> optional<pair<Unicode, KeyModifiers>> {
+  static const map<Unicode, Unicode> FunctionalKeys{
+    {27, '\x1b'},
+    {13, Key::Enter},
+    {9, Key::Tab},
+    {127, Key::Backspace}
+  };
+  static const map<Unicode, Unicode> FinalKeys{
+    {'A', Key::Up},
+    {'B', Key::Down},
+    {'C', Key::Right},
+    {'D', Key::Left},
+    {'H', Key::Home},
+    {'F', Key::End},
+    {'P', Key::F1},
+    {'Q', Key::F2},
+    {'R', Key::F3},
+    {'S', Key::F4}
+  };
+  static const map<Unicode, Unicode> TildeKeys{
+    {1, Key::Home},
+    {2, Key::Insert},
+    {3, Key::Delete},
+    {4, Key::End},
+    {5, Key::PageUp},
+    {6, Key::PageDown},
+    {7, Key::Home},
+    {8, Key::End},
+    {11, Key::F1},
+    {12, Key::F2},
+    {13, Key::F3},
+    {14, Key::F4},
+    {15, Key::F5},
+    {17, Key::F6},
+    {18, Key::F7},
+    {19, Key::F8},
+    {20, Key::F9},
+    {21, Key::F10},
+    {23, Key::F11},
+    {24, Key::F12}
+  };
+  static const Unicode ControlMask{0x1f};
+  // Parameters: first sub-parameter of the first two fields
+  array<Unicode, 2> parameters{1, 1};
+  size_t field{0};
+  bool subParameter{false};
+  bool empty{true};
+  for (auto ch: u32string_view{sequence}.substr(2, sequence.size() - 3)) {
+    if (ch == ';') {
+      ++field;
+      subParameter = false;
+      empty = true;
+    } else if (ch == ':') {
+      subParameter = true;
+    } else if (ch >= '0' and ch <= '9') {
+      if (field < parameters.size() and !subParameter) {
+        const auto digit{static_cast<Unicode>(ch - '0')};
+        parameters.at(field) = empty? digit: parameters.at(field) * 10 + digit; // NOLINT(readability-magic-numbers)
+        empty = false;
+      }
+    } else {
+      return nullopt;
+    }
+  }
+  const auto modifierBits{static_cast<u1>(parameters[1] - 1)};
+  const KeyModifiers modifiers{
+    static_cast<u1>(modifierBits & 1U),
+    static_cast<u1>((modifierBits >> 1U) & 1U),
+    static_cast<u1>((modifierBits >> 2U) & 1U),
+    static_cast<u1>((modifierBits >> 3U) & 1U),
+    static_cast<u1>((modifierBits >> 4U) & 1U),
+    static_cast<u1>((modifierBits >> 5U) & 1U),
+    static_cast<u1>((modifierBits >> 6U) & 1U),
+    static_cast<u1>((modifierBits >> 7U) & 1U)
+  };
+  const auto final_{sequence.back()};
+  if (final_ == 'u') {
+    const auto code{parameters[0]};
+    if (const auto functional{FunctionalKeys.find(code)}; functional != FunctionalKeys.end()) {
+      return pair{modifiedKey(functional->second, modifiers), modifiers};
+    }
+    if (modifiers.control and !modifiers.alt and code >= '@' and code < '\x7f') {
+      // Legacy equivalent is a control character
+      return pair{code & ControlMask, modifiers};
+    }
+    return pair{code, modifiers};
+  }
+  if (final_ == '~') {
+    if (const auto key{TildeKeys.find(parameters[0])}; key != TildeKeys.end()) {
+      return pair{modifiedKey(key->second, modifiers), modifiers};
+    }
+    return nullopt;
+  }
+  if (const auto key{FinalKeys.find(final_)}; key != FinalKeys.end()) {
+    return pair{modifiedKey(key->second, modifiers), modifiers};
+  }
+  return nullopt;
+}
 } // namespace
 
 //~Keyboard~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 Keyboard::Keyboard(int device, const Vector &offset):
-keyPrefixes_(loadKeyTranslations(keyTranslations)),
 fd_(device),
 displayOffset_(offset)
 {
@@ -384,31 +641,164 @@ void Keyboard::reset() {
   }
 }
 
+auto Keyboard::readByte(char &byte, bool wait) -> ssize_t {
+  if (readPosition_ == readBuffer_.size()) {
+    if (!wait) {
+      auto st{fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK)/*NOLINT*/};
+      if (st != 0) {
+        cerr << format("fcntl(F_SETFL, O_NONBLOCK) returned {}\n", st);
+      }
+    } else if (interruptFd_ >= 0) {
+      std::array<pollfd, 2> fds{{{fd_, POLLIN, 0}, {interruptFd_, POLLIN, 0}}};
+      while (::poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno != EINTR) {
+          throw std::system_error(errno, std::system_category(), format("Could not poll keyboard {}", fd_));
+        }
+      }
+      if (fds[1].revents != 0) {
+        throw Interrupted(format("Read from keyboard {} interrupted", fd_));
+      }
+    }
+    readBuffer_.resize(ReadBufferSize);
+    auto readLength{read(fd_, readBuffer_.data(), readBuffer_.size())};
+    auto readError{errno};
+    readBuffer_.resize(std::max(readLength, ssize_t{0}));
+    readPosition_ = 0;
+    if (!wait) {
+      auto st{fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_NONBLOCK)/*NOLINT*/};
+      if (st != 0) {
+        cerr << format("fcntl(F_SETFL, 0) returned {}\n", st);
+      }
+    }
+    if (readLength <= 0) {
+      errno = readError;
+      return readLength;
+    }
+    if (recordFd_ >= 0) {
+      static const auto *const HexDigits{"0123456789abcdef"};
+      string line{format("{} ", std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - recordStart_).count())};
+      for (const auto byte: readBuffer_) {
+        line += HexDigits[static_cast<u1>(byte) >> 4U]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        line += HexDigits[static_cast<u1>(byte) & 0xfU]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      }
+      line += '\n';
+      if (::write(recordFd_, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+        throw std::system_error(errno, std::system_category(), format("Could not record input to fd {}", recordFd_));
+      }
+    }
+  }
+  byte = readBuffer_[readPosition_++];
+  return 1;
+}
+
+auto Keyboard::keyPrefixes() -> const PrefixTree & {
+  static constexpr PrefixTree Prefixes{KeyPrefixNodes};
+  return Prefixes;
+}
+
+void Keyboard::record(int output) {
+  recordFd_ = output;
+  recordStart_ = steady_clock::now();
+}
+
+auto Keyboard::pending() const -> bool {
+  return !keyBuffer_.empty() or readPosition_ < readBuffer_.size();
+}
+
+void Keyboard::unreadByte() {
+  if (readPosition_ > 0) {
+    --readPosition_;
+  }
+}
+
+auto Keyboard::utf8Key(char lead) -> Unicode {
+  static const u1
+    ContinuationMask{0xc0},
+    Continuation{0x80},
+    PayloadMask{0x3f},
+    PayloadBits{6};
+  static const Unicode MaxRune{0x10ffff}, SurrogatesBegin{0xd800}, SurrogatesEnd{0xe000};
+  // Sequence length and minimum code point by lead byte
+  static const array<tuple<u1, u1, u1, Unicode>, 3> Leads{
+    tuple<u1, u1, u1, Unicode>{0xe0, 0xc0, 0x1f, 0x80},
+    tuple<u1, u1, u1, Unicode>{0xf0, 0xe0, 0x0f, 0x800},
+    tuple<u1, u1, u1, Unicode>{0xf8, 0xf0, 0x07, 0x10000}
+  };
+  const auto lead_{static_cast<u1>(lead)};
+  for (size_t length = 2; const auto &[mask, pattern, payload, minimum]: Leads) {
+    if ((lead_ & mask) == pattern) {
+      Unicode result{static_cast<Unicode>(lead_ & payload)};
+      for (size_t i = 1; i < length; ++i) {
+        char byte{0};
+        if (readByte(byte) <= 0) {
+          return ReplacementRune;
+        }
+        if ((static_cast<u1>(byte) & ContinuationMask) != Continuation) {
+          // Not a continuation byte: leave it for the next key
+          unreadByte();
+          return ReplacementRune;
+        }
+        result = result << PayloadBits | (static_cast<u1>(byte) & PayloadMask);
+      }
+      if (result < minimum or result > MaxRune or (result >= SurrogatesBegin and result < SurrogatesEnd)) {
+        return ReplacementRune;
+      }
+      return result;
+    }
+    ++length;
+  }
+  return ReplacementRune;
+}
+
+auto Keyboard::asciiKeys() -> bool {
+  const auto length{printableAsciiLength(string_view{readBuffer_}.substr(readPosition_))};
+  for (const auto byte: string_view{readBuffer_}.substr(readPosition_, length)) {
+    keyBuffer_.emplace_back(static_cast<Unicode>(byte), KeyModifiers{});
+  }
+  readPosition_ += length;
+  return length > 0;
+}
+
+void Keyboard::csiKey(u32string sequence) {
+  static const Unicode ParameterBegin{0x30}, ParameterEnd{0x40}, FinalEnd{0x7f};
+  while (sequence.back() >= ParameterBegin and sequence.back() < ParameterEnd) {
+    char byte{0};
+    if (readByte(byte) <= 0) {
+      break;
+    }
+    sequence.push_back(static_cast<u1>(byte));
+  }
+  if (sequence.back() >= ParameterEnd and sequence.back() < FinalEnd) {
+    if (const auto key{decodeCsi(sequence)}) {
+      keyBuffer_.push_back(key.value());
+      return;
+    }
+  }
+  for (const auto ch: sequence) {
+    keyBuffer_.emplace_back(ch, KeyModifiers{});
+  }
+}
+
 auto Keyboard::key() -> Unicode {
   Unicode key{0};
-  if (!keyBuffer_.empty()) {
-    key = keyBuffer_.front();
+  if (!keyBuffer_.empty() or asciiKeys()) {
+    std::tie(key, modifiers_) = keyBuffer_.front();
     keyBuffer_.pop_front();
     return key;
   }
   char inputKey = 0;
-  auto *node{&keyPrefixes_};
+  const auto &prefixes{keyPrefixes()};
+  const auto *node{&prefixes.root()};
   u32string inputBuffer;
   while (true) {
     ssize_t readLength = 0;
     steady_clock::duration readTime;
-    auto onSublevel{node != &keyPrefixes_}; // If true expect more keys in quick succession
-    if (onSublevel) {
-      auto st{fcntl(fd_, F_SETFL, fcntl(0, F_GETFL) | O_NONBLOCK)/*NOLINT*/};
-      if (st != 0) {
-        cerr << format("fcntl(F_SETFL, O_NONBLOCK) returned {}\n", st);
-      }
-    }
+    auto onSublevel{node != &prefixes.root()}; // If true expect more keys in quick succession
     auto start{steady_clock::now()};
     auto attempt{0};
     // Handle reattempts and simulated delays
     while (true) {
-      readLength = read(fd_, &inputKey, 1);
+      readLength = readByte(inputKey, !onSublevel or kittyProtocol_);
       if (readLength < 0) {
         if (errno != EAGAIN) {
           throw std::system_error(errno, std::system_category(), format("Could not get key: {}", fd_, std::strerror(errno)/*NOLINT*/));
@@ -426,32 +816,46 @@ auto Keyboard::key() -> Unicode {
       }
     };
     readTime = steady_clock::now() - start;
-    if (onSublevel) {
-      auto st{fcntl(fd_, F_SETFL, fcntl(0, F_GETFL) & ~O_NONBLOCK)/*NOLINT*/};
-      if (st != 0) {
-        cerr << format("fcntl(F_SETFL, 0) returned {}\n", st);
-      }
-    }
-    if (readLength == 0) {
+    if (readLength <= 0) {
       inputKey = '\0';
+    } else if (!onSublevel and isPrintableAscii(inputKey)) {
+      // No key sequence starts with a printable character: take the fast path
+      unreadByte();
+      asciiKeys();
+      break;
+    } else if (!onSublevel and (static_cast<u1>(inputKey) & 0x80U) != 0) {
+      keyBuffer_.emplace_back(utf8Key(inputKey), KeyModifiers{});
+      break;
     } else {
-      inputBuffer.push_back(inputKey);
+      inputBuffer.push_back(static_cast<u1>(inputKey));
     }
-    auto subnodeIt{node->nodes.find(inputKey)};
-    if (onSublevel and readTime > 2ms or subnodeIt == node->nodes.end()) {
-      copy(inputBuffer.begin(), inputBuffer.end(), back_inserter(keyBuffer_));
+    const auto *subnode{prefixes.child(*node, inputKey)};
+    if (onSublevel and !kittyProtocol_ and readTime > 2ms or subnode == nullptr) {
+      if (kittyProtocol_ and readLength > 0 and inputBuffer.starts_with(U"\x1b[") and inputKey >= '0' and inputKey <= '~') {
+        // Keys not in the prefix tree, e.g. kitty keyboard protocol reports
+        csiKey(inputBuffer);
+        break;
+      }
+      if (onSublevel and readLength > 0) {
+        // Byte does not continue the sequence: leave it for the next key
+        unreadByte();
+        inputBuffer.pop_back();
+      }
+      for (const auto ch: inputBuffer) {
+        keyBuffer_.emplace_back(ch, KeyModifiers{});
+      }
       break;
     }
-    node = subnodeIt->second.get();
+    node = subnode;
     if (node->key != Key::None) {
-      keyBuffer_.push_back(node->key);
+      keyBuffer_.emplace_back(node->key, KeyModifiers{});
       break;
     }
   }
   if (keyBuffer_.empty()) {
     throw runtime_error("Key buffer is empty");
   }
-  key = keyBuffer_.front();
+  std::tie(key, modifiers_) = keyBuffer_.front();
   keyBuffer_.pop_front();
   return key;
 }
@@ -501,7 +905,7 @@ auto Keyboard::event() -> Event {
     }
     return Event{new MouseButtonEvent{button, modifiers, position, action}};
   }
-  return Event{new KeyEvent{key_}};
+  return Event{new KeyEvent{key_, modifiers_}};
 }
 
 auto MouseEvent::translated(const Vector &shift) -> MouseEvent {
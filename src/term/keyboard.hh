@@ -5,15 +5,17 @@
 #include <term/text.hh>
 #include <util/basic.hh>
 
+#include <chrono>
 #include <deque>
-#include <map>
-#include <memory>
 #include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <termios.h>
 
 namespace jwezel {
 
-using std::tuple, std::unique_ptr;
+using std::pair, std::tuple, std::u32string;
 
 enum Key: Unicode {
   None = 0x0fff0000,
@@ -177,18 +179,36 @@ struct MouseModifiers {
   u1 mod6: 1;
 };
 
+///
+/// Key modifiers
+///
+/// Bit layout follows the modifier encoding of the kitty keyboard protocol.
+struct KeyModifiers {
+  u1 shift: 1;
+  u1 alt: 1;
+  u1 control: 1;
+  u1 super: 1;
+  u1 hyper: 1;
+  u1 meta: 1;
+  u1 capsLock: 1;
+  u1 numLock: 1;
+};
+
 struct InputEvent: public BaseEvent {
   CLASS_ID(InputEvent);
 };
 
 struct KeyEvent: public InputEvent {
-  [[nodiscard]] explicit KeyEvent(Unicode key):
-    key_(key) {}
+  [[nodiscard]] explicit KeyEvent(Unicode key, const KeyModifiers &modifiers={}):
+    key_(key), modifiers_(modifiers) {}
 
   [[nodiscard]] inline auto key() const -> auto {return key_;}
 
+  [[nodiscard]] inline auto modifiers() const {return modifiers_;}
+
   private:
   Unicode key_;
+  KeyModifiers modifiers_;
 
   CLASS_ID(KeyEvent);
 };
@@ -239,10 +259,47 @@ struct MouseMoveEvent: MouseEvent {
 struct Keyboard {
 
   ///
-  /// Key prefix tree node
-  struct PrefixNode {
-    Unicode key = Key::None;
-    std::map<char, unique_ptr<PrefixNode>> nodes{};
+  /// Error thrown when a blocking read is interrupted
+  struct Interrupted: std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  ///
+  /// Key prefix tree
+  ///
+  /// Generated at compile time into a flat array. Nodes are numbered breadth
+  /// first, so the children of a node are adjacent.
+  struct PrefixTree {
+    ///
+    /// Key prefix tree node
+    struct Node {
+      Unicode key = Key::None; //< Key if the path to the node is a complete sequence
+      u2 children{0};          //< Index of first child
+      u2 childCount{0};        //< Number of children
+      char byte{};             //< Byte leading to the node
+    };
+
+    std::span<const Node> nodes; //< Nodes, root first
+
+    [[nodiscard]] constexpr auto root() const -> const Node & {return nodes.front();}
+
+    [[nodiscard]] constexpr auto children(const Node &node) const {return nodes.subspan(node.children, node.childCount);}
+
+    ///
+    /// Get child of node
+    ///
+    /// @param[in]  node  The node
+    /// @param[in]  byte  The byte leading to the child
+    ///
+    /// @return     Child, nullptr if the byte does not continue a sequence
+    [[nodiscard]] constexpr auto child(const Node &node, char byte) const -> const Node * {
+      for (const auto &child: children(node)) {
+        if (child.byte == byte) {
+          return &child;
+        }
+      }
+      return nullptr;
+    }
   };
 
   ///
@@ -277,13 +334,26 @@ struct Keyboard {
   /// @return     key
   [[nodiscard]] auto key() -> Unicode;
 
+  ///
+  /// Get modifiers of last key
+  ///
+  /// Only reported by terminals using the kitty keyboard protocol.
+  ///
+  /// @return     Key modifiers
+  [[nodiscard]] auto modifiers() const -> KeyModifiers {return modifiers_;}
+
   ///
   /// Mouse report
   ///
   /// @return     Terminal mouse event data
   auto mouseReport() -> tuple<MouseButton, MouseModifiers, Vector, MouseAction>;
 
-  [[nodiscard]] auto keyPrefixes() const -> const PrefixNode & {return keyPrefixes_;}
+  ///
+  /// Get key prefix tree
+  ///
+  /// @return     Key prefix tree of all known key sequences
+  [[nodiscard]] static auto keyPrefixes() -> const PrefixTree &;
+
   ///
   /// Get input event
   ///
@@ -294,12 +364,92 @@ struct Keyboard {
     displayOffset_ = offset;
   }
 
+  ///
+  /// Set whether the terminal sends kitty keyboard protocol reports
+  ///
+  /// With the protocol active, Escape is reported as a sequence of its own, so
+  /// escape sequences are read without timeout.
+  ///
+  /// @param[in]  enable  Whether the protocol is active
+  inline void kittyProtocol(bool enable) {
+    kittyProtocol_ = enable;
+  }
+
+  [[nodiscard]] inline auto kittyProtocol() const {return kittyProtocol_;}
+
+  [[nodiscard]] inline auto fd() const {return fd_;}
+
+  ///
+  /// Record raw input
+  ///
+  /// Every chunk read from the terminal is written to @arg output as a line
+  /// `<microseconds since start of recording> <hex bytes>`.
+  ///
+  /// @param[in]  output  File descriptor to record to (-1 stops recording)
+  void record(int output);
+
+  ///
+  /// Set file descriptor interrupting blocking reads
+  ///
+  /// While @arg fd is readable, reads which would block throw Interrupted
+  /// instead, so a thread waiting for the rest of a sequence can be stopped.
+  ///
+  /// @param[in]  fd    The file descriptor (-1 for none)
+  inline void interrupt(int fd) {
+    interruptFd_ = fd;
+  }
+
+  ///
+  /// Determine whether input is waiting to be returned by key()
+  ///
+  /// @return     True if keys or undecoded input are buffered
+  [[nodiscard]] auto pending() const -> bool;
+
   private:
-  std::deque<Unicode> keyBuffer_; //< Key buffer
-  PrefixNode keyPrefixes_; //< Key prefix tree
+  ///
+  /// Read byte from input buffer, refilling it from the terminal when empty
+  ///
+  /// @param[out] byte  The byte
+  /// @param[in]  wait  Whether to block until input is available
+  ///
+  /// @return     Number of bytes read (1), 0 on end of input, -1 on error
+  auto readByte(char &byte, bool wait=true) -> ssize_t;
+
+  ///
+  /// Return last byte read to the input buffer
+  void unreadByte();
+
+  ///
+  /// Decode UTF-8 sequence into a code point
+  ///
+  /// @param[in]  lead  The lead byte
+  ///
+  /// @return     Code point (U+FFFD if the sequence is malformed)
+  auto utf8Key(char lead) -> Unicode;
+
+  ///
+  /// Move run of printable ASCII characters from input buffer to key buffer
+  ///
+  /// @return     Whether any keys were added
+  auto asciiKeys() -> bool;
+
+  ///
+  /// Complete and decode control sequence which is not in the key prefix tree
+  ///
+  /// @param[in]  sequence  The sequence read so far
+  void csiKey(u32string sequence);
+
+  std::deque<pair<Unicode, KeyModifiers>> keyBuffer_; //< Key buffer
+  std::string readBuffer_; //< Raw input not yet decoded
+  size_t readPosition_{0}; //< Position of next byte in readBuffer_
   int fd_; //< Terminal file descriptor
   std::optional<termios> originalState_; //< Original terminal state
   Vector displayOffset_;
+  KeyModifiers modifiers_{}; //< Modifiers of last key
+  bool kittyProtocol_{false}; //< Whether kitty keyboard protocol is active
+  int recordFd_{-1}; //< Input recording file descriptor
+  int interruptFd_{-1}; //< File descriptor interrupting blocking reads
+  std::chrono::steady_clock::time_point recordStart_; //< Start of input recording
 };
 
 } // namespace jwezel
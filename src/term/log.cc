@@ -0,0 +1,252 @@
+#include "log.hh"
+#include "geometry.hh"
+#include "region.hh"
+#include "surface.hh"
+#include "text.hh"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <utf8cpp/utf8.h>
+
+namespace jwezel {
+
+using std::format, std::out_of_range, std::string, std::string_view;
+
+namespace {
+
+const Unicode ReplacementRune{0xfffd};
+
+///
+/// Append character to UTF-8, expanding tabs and replacing control characters
+///
+/// @param[in]  rune    The character
+/// @param[in]  column  The column of the character
+/// @param      bytes   The UTF-8
+///
+/// @return     The column following the character
+auto put(Unicode rune, u4 column, string &bytes) -> u4 {
+  if (rune == '\t') {
+    const auto next{u4((column / LogElement::TabSize + 1) * LogElement::TabSize)};
+    bytes.append(next - column, ' ');
+    return next;
+  }
+  utf8::append(rune < ' ' or rune == 0x7f? ReplacementRune: rune, back_inserter(bytes));
+  return column + 1;
+}
+
+} // namespace
+
+LogElement::LogElement(
+  Surface *surface,
+  const Rectangle &area,
+  size_t retention,
+  const Char &background,
+  Surface::Element *below
+):
+Element{surface},
+area_{area},
+background_{background},
+retention_{retention}
+{
+  surface->addElement(this, below);
+}
+
+LogElement::~LogElement() {
+  try {
+    surface()->deleteElement(this);
+  } catch (std::exception & error) {
+    std::cerr << error.what() << '\n';
+  }
+}
+
+auto LogElement::append(string_view line, const CharAttributes &attributes) -> LogElement & {
+  auto &page_{page()};
+  page_.lines.push_back(u4(page_.bytes.size()));
+  const auto control{std::ranges::any_of(line, [](char byte) {return u1(byte) < ' ' or u1(byte) == 0x7f;})};
+  const auto valid{utf8::is_valid(line.begin(), line.end())};
+  if (valid and !control) {
+    page_.bytes.append(line);
+  } else {
+    string replaced;
+    if (!valid) {
+      utf8::replace_invalid(line.begin(), line.end(), back_inserter(replaced));
+      line = replaced;
+    }
+    u4 column{0};
+    for (auto position{line.begin()}; position != line.end();) {
+      column = put(Unicode(utf8::next(position, line.end())), column, page_.bytes);
+    }
+  }
+  page_.runs.push_back(u4(page_.styleRuns.size()));
+  page_.styleRuns.push_back(Run{0, style(attributes)});
+  ++end_;
+  appended(1);
+  return *this;
+}
+
+auto LogElement::append(const Text &text) -> LogElement & {
+  for (const auto &row: text.data) {
+    auto &page_{page()};
+    page_.lines.push_back(u4(page_.bytes.size()));
+    page_.runs.push_back(u4(page_.styleRuns.size()));
+    u4 column{0};
+    for (const auto &cell: row) {
+      const auto style_{style(cell.attributes)};
+      if (page_.styleRuns.size() == page_.runs.back() or page_.styleRuns.back().style != style_) {
+        page_.styleRuns.push_back(Run{column, style_});
+      }
+      column = put(cell.rune, column, page_.bytes);
+    }
+    ++end_;
+  }
+  appended(text.data.size());
+  return *this;
+}
+
+auto LogElement::line(size_t number) const -> Text {
+  if (number < first_ or number >= end_) {
+    throw out_of_range(format("Line {} is not kept (lines {} to {})", number, first_, end_));
+  }
+  Text result;
+  result.data.push_back(render(number, 0, DimHigh));
+  return result;
+}
+
+void LogElement::top(size_t number) {
+  follow_ = false;
+  (void)scrollTo(std::clamp(number, first_, end_ > first_? end_ - 1: first_));
+}
+
+void LogElement::follow(bool follow) {
+  follow_ = follow;
+  if (follow) {
+    (void)scrollTo(bottom());
+  }
+}
+
+auto LogElement::moveEvent(const Rectangle &area) -> bool {
+  area_ = area;
+  if (follow_) {
+    top_ = bottom();
+  }
+  return true;
+}
+
+auto LogElement::text(const Rectangle &area) const -> Text {
+  const auto visible{area & Rectangle{Vector{0, 0}, area_.size()}};
+  Text result;
+  if (!visible) {
+    return result;
+  }
+  result.data.reserve(visible->height());
+  for (auto row = visible->y1(); row < visible->y2(); ++row) {
+    const auto number{top_ + size_t(row)};
+    auto line_{number >= first_ and number < end_? render(number, visible->x1(), visible->x2()): String{}};
+    line_.resize(size_t(visible->width()), background_);
+    result.data.push_back(std::move(line_));
+  }
+  return result;
+}
+
+auto LogElement::StyleHash::operator()(const CharAttributes &attributes) const -> size_t {
+  static const size_t Factor{31};
+  const std::hash<f4> hash;
+  auto result{size_t(attributes.attr) << 8U | size_t(attributes.mix)};
+  for (const auto value: {attributes.fg.r, attributes.fg.g, attributes.fg.b, attributes.bg.r, attributes.bg.g, attributes.bg.b}) {
+    result = result * Factor + hash(value);
+  }
+  return result;
+}
+
+auto LogElement::style(const CharAttributes &attributes) -> u4 {
+  auto &styles{pages_.back().styles};
+  const auto [found, added]{styles_.try_emplace(attributes, u4(styles.size()))};
+  if (added) {
+    styles.push_back(attributes);
+  }
+  return found->second;
+}
+
+auto LogElement::page() -> Page & {
+  if (pages_.empty() or pages_.back().lines.size() == PageLines) {
+    // All pages are full here, drop those not needed to keep the retention
+    while (!pages_.empty() and end_ - first_ - PageLines >= retention_) {
+      pages_.pop_front();
+      first_ += PageLines;
+    }
+    pages_.emplace_back();
+    // Styles are kept per page, so they are dropped with it
+    styles_.clear();
+  }
+  return pages_.back();
+}
+
+void LogElement::appended(size_t count) {
+  const auto height{size_t(area_.height())};
+  const auto previousTop{top_};
+  auto updated{false};
+  if (follow_) {
+    updated = scrollTo(bottom());
+  } else if (top_ < first_) {
+    updated = scrollTo(first_);
+  }
+  // Lines appended inside of the previous view were not scrolled in
+  const auto from{std::max(end_ - count, top_)}, to{std::min(end_, previousTop + height)};
+  if (!updated and from < to) {
+    update(Region(Rectangle{0, Dim(from - top_), area_.width(), Dim(to - top_)}));
+  }
+}
+
+auto LogElement::scrollTo(size_t number) -> bool {
+  if (number == top_) {
+    return false;
+  }
+  const auto previousTop{top_};
+  const auto distance{number > top_? number - top_: top_ - number};
+  top_ = number;
+  const Rectangle all{Vector{0, 0}, area_.size()};
+  if (distance < size_t(area_.height())) {
+    shift(all, Vector{0, number > previousTop? Dim(-Dim(distance)): Dim(distance)});
+    return false;
+  }
+  update(Region(all));
+  return true;
+}
+
+auto LogElement::bottom() const -> size_t {
+  const auto height{size_t(area_.height())};
+  return std::max(first_, end_ > height? end_ - height: 0);
+}
+
+auto LogElement::render(size_t number, Dim x1, Dim x2) const -> String {
+  const auto index{number - first_};
+  const auto &page_{pages_[index / PageLines]};
+  const auto line_{index % PageLines};
+  const auto last{line_ + 1 == page_.lines.size()};
+  auto position{page_.bytes.begin() + page_.lines[line_]};
+  const auto end{last? page_.bytes.end(): page_.bytes.begin() + page_.lines[line_ + 1]};
+  auto run{page_.styleRuns.begin() + page_.runs[line_]};
+  const auto runEnd{last? page_.styleRuns.end(): page_.styleRuns.begin() + page_.runs[line_ + 1]};
+  String result;
+  CharAttributes attributes;
+  for (Dim column = 0; position != end and column < x2; ++column) {
+    const auto rune{utf8::next(position, end)};
+    while (run != runEnd and run->column <= u4(column)) {
+      attributes = page_.styles[run->style];
+      ++run;
+    }
+    if (column >= x1) {
+      result.emplace_back(Unicode(rune), attributes);
+    }
+  }
+  return result;
+}
+
+} // namespace jwezel
@@ -0,0 +1,222 @@
+///
+/// @defgroup   LOG log
+///
+/// This file defines an element showing a log with scrollback.
+
+#pragma once
+
+#include "geometry.hh"
+#include "surface.hh"
+#include "text.hh"
+
+#include <util/basic.hh>
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jwezel {
+
+///
+/// Scrollable view of a log
+///
+/// Lines are stored as UTF-8 with runs of attributes in pages of a fixed
+/// number of lines, and converted to characters only while visible. Once more
+/// lines than the retention are kept, the oldest pages are dropped along with
+/// the attributes they use. Tabs are expanded and control characters replaced
+/// when appending.
+///
+/// Lines are numbered from the first line ever appended, so numbers stay valid
+/// when old lines are dropped.
+struct LogElement: Surface::Element {
+  ///
+  /// Lines per page
+  static constexpr size_t PageLines{1024};
+
+  ///
+  /// Default number of lines kept
+  static constexpr size_t DefaultRetention{1'000'000};
+
+  ///
+  /// Columns of a tab stop
+  static constexpr size_t TabSize{8};
+
+  ///
+  /// Constructor
+  ///
+  /// @param[in]  surface     The surface
+  /// @param[in]  area        The area
+  /// @param[in]  retention   Minimum number of lines kept
+  /// @param[in]  background  The background
+  /// @param[in]  below       The element to insert below
+  explicit LogElement(
+    Surface *surface,
+    const Rectangle &area,
+    size_t retention=DefaultRetention,
+    const Char &background=Space,
+    Surface::Element *below=0
+  );
+
+  LogElement() = default;
+
+  LogElement(const LogElement &) = default;
+
+  LogElement(LogElement &&) = default;
+
+  auto operator=(const LogElement &) -> LogElement & = default;
+
+  auto operator=(LogElement &&) -> LogElement & = default;
+
+  ///
+  /// Destroy LogElement
+  ~LogElement() override;
+
+  ///
+  /// Append line
+  ///
+  /// @param[in]  line        The line in UTF-8
+  /// @param[in]  attributes  The attributes of the line
+  ///
+  /// @return     this
+  auto append(std::string_view line, const CharAttributes &attributes=CharAttributes{}) -> LogElement &;
+
+  ///
+  /// Append every line of text
+  ///
+  /// @param[in]  text  The text
+  ///
+  /// @return     this
+  auto append(const Text &text) -> LogElement &;
+
+  ///
+  /// Get line
+  ///
+  /// Throws out_of_range if the line is not kept.
+  ///
+  /// @param[in]  number  The line number
+  ///
+  /// @return     The line
+  [[nodiscard]] auto line(size_t number) const -> Text;
+
+  ///
+  /// Get number of the oldest line kept
+  [[nodiscard]] inline auto first() const {return first_;}
+
+  ///
+  /// Get number following the newest line
+  [[nodiscard]] inline auto end() const {return end_;}
+
+  ///
+  /// Get number of the line shown at the top
+  [[nodiscard]] inline auto top() const {return top_;}
+
+  ///
+  /// Show line at the top
+  ///
+  /// Stops following appended lines.
+  ///
+  /// @param[in]  number  The line number, limited to the lines kept
+  void top(size_t number);
+
+  ///
+  /// Turn following appended lines on/off
+  ///
+  /// Following keeps the newest line at the bottom.
+  ///
+  /// @param[in]  follow  Whether to follow
+  void follow(bool follow);
+
+  [[nodiscard]] inline auto follow() const {return follow_;}
+
+  [[nodiscard]] auto area() const -> Rectangle override {return area_;}
+
+  auto moveEvent(const Rectangle &area) -> bool override;
+
+  ///
+  /// Render visible lines
+  ///
+  /// @param[in]  area  The area
+  ///
+  /// @return     text
+  [[nodiscard]] auto text(const Rectangle &area=RectangleMax) const -> Text override;
+
+  private:
+  ///
+  /// Columns from which on an attribute applies
+  struct Run {
+    u4 column; //< First column
+    u4 style;  //< Index of attributes in the styles of the page
+  };
+
+  ///
+  /// Lines stored together
+  struct Page {
+    std::string bytes;              //< UTF-8 of all lines
+    vector<u4> lines;               //< Offset of every line in bytes
+    vector<u4> runs;                //< Index of the first run of every line in styleRuns
+    vector<Run> styleRuns;          //< Runs of all lines
+    vector<CharAttributes> styles;  //< Attributes used by runs
+  };
+
+  ///
+  /// Hash of attributes
+  struct StyleHash {
+    auto operator()(const CharAttributes &attributes) const -> size_t;
+  };
+
+  ///
+  /// Get index of attributes in the last page, adding them if new
+  ///
+  /// @param[in]  attributes  The attributes
+  ///
+  /// @return     The index
+  auto style(const CharAttributes &attributes) -> u4;
+
+  ///
+  /// Get page to append line to, dropping pages beyond the retention
+  ///
+  /// @return     The page
+  auto page() -> Page &;
+
+  ///
+  /// Update view after appending lines
+  ///
+  /// @param[in]  count  Number of lines appended
+  void appended(size_t count);
+
+  ///
+  /// Show line at the top, updating what changed
+  ///
+  /// @param[in]  number  The line number
+  ///
+  /// @return     Whether the whole element was updated
+  auto scrollTo(size_t number) -> bool;
+
+  ///
+  /// Get number of the top line showing the newest line at the bottom
+  [[nodiscard]] auto bottom() const -> size_t;
+
+  ///
+  /// Render line
+  ///
+  /// @param[in]  number  The line number
+  /// @param[in]  x1      First column
+  /// @param[in]  x2      End column
+  ///
+  /// @return     Characters of the columns the line reaches
+  [[nodiscard]] auto render(size_t number, Dim x1, Dim x2) const -> String;
+
+  Rectangle area_;
+  Char background_;
+  std::deque<Page> pages_;             //< Pages, the first starting with line first_
+  std::unordered_map<CharAttributes, u4, StyleHash> styles_; //< Styles of the last page by attributes
+  size_t retention_{DefaultRetention}; //< Minimum number of lines kept
+  size_t first_{0};                    //< Number of the oldest line kept
+  size_t end_{0};                      //< Number following the newest line
+  size_t top_{0};                      //< Number of the line shown at the top
+  bool follow_{true};                  //< Whether the newest line is kept at the bottom
+};
+
+} // namespace jwezel
@@ -0,0 +1,232 @@
+#include "region.hh"
+#include "geometry.hh"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jwezel {
+
+using std::format, std::pair;
+
+namespace
+{
+
+using Spans = boost::container::small_vector<pair<Dim, Dim>, 8>;
+
+///
+/// Get end of band
+///
+/// @param[in]  begin  The first rectangle of the band
+/// @param[in]  end    The end of the rectangles
+///
+/// @return     The first rectangle after the band
+auto bandEnd(const Rectangle *begin, const Rectangle *end) -> const Rectangle * {
+  return std::find_if(begin, end, [begin](const Rectangle &r) {return r.y1() != begin->y1();});
+}
+
+///
+/// Combine horizontal spans of two bands
+///
+/// Walks both bands from left to right, cutting them at every edge.
+///
+/// @param[in]  band1   Rectangles of band 1, empty if the row is not in region 1
+/// @param[in]  band2   Rectangles of band 2, empty if the row is not in region 2
+/// @param[in]  keep    Whether to keep a cell given whether it is in band 1 and 2
+/// @param[out] result  The combined spans
+void combineSpans(std::span<const Rectangle> band1, std::span<const Rectangle> band2, auto keep, Spans &result) {
+  result.clear();
+  auto it1{band1.begin()};
+  auto it2{band2.begin()};
+  Dim x{DimLow};
+  while (it1 != band1.end() or it2 != band2.end()) {
+    const auto left1{it1 != band1.end()? std::max(it1->x1(), x): DimHigh};
+    const auto left2{it2 != band2.end()? std::max(it2->x1(), x): DimHigh};
+    const auto left{std::min(left1, left2)};
+    const auto in1{left1 == left};
+    const auto in2{left2 == left};
+    const auto right{std::min(in1? it1->x2(): left1, in2? it2->x2(): left2)};
+    if (keep(in1, in2)) {
+      if (!result.empty() and result.back().second == left) {
+        result.back().second = right;
+      } else {
+        result.emplace_back(left, right);
+      }
+    }
+    x = right;
+    if (in1 and it1->x2() == right) {
+      ++it1;
+    }
+    if (in2 and it2->x2() == right) {
+      ++it2;
+    }
+  }
+}
+
+///
+/// Union of rectangles by merging halves
+///
+/// @param[in]  rectangles  The rectangles
+///
+/// @return     Region
+auto unite(std::span<const Rectangle> rectangles) -> Region {
+  if (rectangles.size() == 1) {
+    return Region(rectangles.front());
+  }
+  const auto half{rectangles.size() / 2};
+  return unite(rectangles.first(half)) | unite(rectangles.subspan(half));
+}
+
+} // namespace
+
+Region::Region(const Rectangle &rectangle) {
+  if (rectangle.x1() < rectangle.x2() and rectangle.y1() < rectangle.y2()) {
+    rectangles_.push_back(rectangle);
+  }
+}
+
+Region::Region(const vector<Rectangle> &rectangles) {
+  if (!rectangles.empty()) {
+    *this = unite(rectangles);
+  }
+}
+
+Region::Region(std::initializer_list<Rectangle> rectangles):
+Region{vector<Rectangle>{rectangles}}
+{}
+
+Region::operator string() const {
+  string result;
+  for (const auto &rectangle: rectangles_) {
+    result += (result.empty()? "": ", ") + string(rectangle);
+  }
+  return format("Region({})", result);
+}
+
+auto Region::combine(const Region &region1, const Region &region2, Operation operation) -> Region {
+  const auto keep{[operation](bool in1, bool in2) {
+    switch (operation) {
+      case Operation::union_:
+      return in1 or in2;
+
+      case Operation::intersection:
+      return in1 and in2;
+
+      default:
+      return in1 and !in2;
+    }
+  }};
+  // Walk the bands of both regions from top to bottom, cutting them at every edge
+  const auto *it1{region1.rectangles_.data()};
+  const auto *end1{it1 + region1.rectangles_.size()};
+  const auto *it2{region2.rectangles_.data()};
+  const auto *end2{it2 + region2.rectangles_.size()};
+  const auto *band1End{bandEnd(it1, end1)};
+  const auto *band2End{bandEnd(it2, end2)};
+  Region result;
+  Spans spans;
+  size_t lastBand{0}; // Index of first rectangle of last band in result
+  Dim y{DimLow};
+  while (it1 != end1 or it2 != end2) {
+    if ((it1 == end1 and operation != Operation::union_) or (it2 == end2 and operation == Operation::intersection)) {
+      break;
+    }
+    const auto top1{it1 != end1? std::max(it1->y1(), y): DimHigh};
+    const auto top2{it2 != end2? std::max(it2->y1(), y): DimHigh};
+    const auto y1{std::min(top1, top2)};
+    const auto in1{top1 == y1};
+    const auto in2{top2 == y1};
+    const auto y2{std::min(in1? it1->y2(): top1, in2? it2->y2(): top2)};
+    combineSpans(
+      in1? std::span<const Rectangle>{it1, band1End}: std::span<const Rectangle>{},
+      in2? std::span<const Rectangle>{it2, band2End}: std::span<const Rectangle>{},
+      keep,
+      spans
+    );
+    y = y2;
+    if (in1 and it1->y2() == y2) {
+      it1 = band1End;
+      band1End = bandEnd(it1, end1);
+    }
+    if (in2 and it2->y2() == y2) {
+      it2 = band2End;
+      band2End = bandEnd(it2, end2);
+    }
+    if (spans.empty()) {
+      continue;
+    }
+    auto &rectangles{result.rectangles_};
+    // Extend previous band if it is adjacent and has the same spans
+    const std::span<Rectangle> previous{rectangles.data() + lastBand, rectangles.size() - lastBand};
+    if (
+      !previous.empty() and previous.front().y2() == y1 and previous.size() == spans.size() and
+      std::ranges::equal(previous, spans, [](const Rectangle &r, const pair<Dim, Dim> &s) {
+        return r.x1() == s.first and r.x2() == s.second;
+      })
+    ) {
+      for (auto &rectangle: previous) {
+        rectangle = Rectangle{rectangle.x1(), rectangle.y1(), rectangle.x2(), y2};
+      }
+      continue;
+    }
+    lastBand = rectangles.size();
+    for (const auto &[x1, x2]: spans) {
+      rectangles.emplace_back(x1, y1, x2, y2);
+    }
+  }
+  return result;
+}
+
+auto Region::operator |(const Region &other) const -> Region {
+  if (empty()) {
+    return other;
+  }
+  if (other.empty()) {
+    return *this;
+  }
+  return combine(*this, other, Operation::union_);
+}
+
+auto Region::operator &(const Region &other) const -> Region {
+  if (empty() or other.empty() or !bounds().intersects(other.bounds())) {
+    return {};
+  }
+  return combine(*this, other, Operation::intersection);
+}
+
+auto Region::operator -(const Region &other) const -> Region {
+  if (empty() or other.empty() or !bounds().intersects(other.bounds())) {
+    return *this;
+  }
+  return combine(*this, other, Operation::difference);
+}
+
+auto Region::operator +(const Vector &shift) const -> Region {
+  Region result;
+  result.rectangles_.reserve(rectangles_.size());
+  for (const auto &rectangle: rectangles_) {
+    result.rectangles_.push_back(rectangle + shift);
+  }
+  return result;
+}
+
+auto Region::bounds() const -> Rectangle {
+  if (empty()) {
+    return Rectangle{};
+  }
+  auto result{rectangles_.front()};
+  for (const auto &rectangle: rectangles_) {
+    result |= rectangle;
+  }
+  return result;
+}
+
+auto Region::intersects(const Rectangle &rectangle) const -> bool {
+  return std::ranges::any_of(rectangles_, [&rectangle](const Rectangle &r) {return r.intersects(rectangle);});
+}
+
+} // namespace jwezel
@@ -0,0 +1,139 @@
+///
+/// @defgroup   REGION region
+///
+/// This file defines the Region type.
+
+#pragma once
+
+#include "geometry.hh"
+
+#include <boost/container/small_vector.hpp>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace jwezel {
+
+///
+/// Set of cells described by y-banded rectangles
+///
+/// Rectangles are kept in bands of equal top and bottom, ordered by top, then
+/// left edge. Rectangles of a band neither overlap nor touch, and adjacent bands
+/// with the same horizontal spans are merged, so equal regions have equal
+/// rectangles.
+struct Region {
+  using Rectangles = boost::container::small_vector<Rectangle, 4>;
+
+  Region() = default;
+
+  ///
+  /// Constructor
+  ///
+  /// @param[in]  rectangle  The rectangle (empty rectangles give an empty region)
+  explicit Region(const Rectangle &rectangle);
+
+  ///
+  /// Constructor
+  ///
+  /// @param[in]  rectangles  The rectangles, which may overlap
+  explicit Region(const vector<Rectangle> &rectangles);
+
+  ///
+  /// Constructor
+  ///
+  /// @param[in]  rectangles  The rectangles, which may overlap
+  Region(std::initializer_list<Rectangle> rectangles);
+
+  ///
+  /// String conversion operator.
+  [[nodiscard]] explicit operator string() const;
+
+  [[nodiscard]] auto operator ==(const Region &other) const -> bool = default;
+
+  ///
+  /// Union
+  ///
+  /// @param[in]  other  Other region
+  ///
+  /// @return     Cells in either region
+  [[nodiscard]] auto operator |(const Region &other) const -> Region;
+
+  ///
+  /// Intersection
+  ///
+  /// @param[in]  other  Other region
+  ///
+  /// @return     Cells in both regions
+  [[nodiscard]] auto operator &(const Region &other) const -> Region;
+
+  ///
+  /// Difference
+  ///
+  /// @param[in]  other  Other region
+  ///
+  /// @return     Cells in this region but not in @arg other
+  [[nodiscard]] auto operator -(const Region &other) const -> Region;
+
+  ///
+  /// Translation
+  ///
+  /// @param[in]  shift  The shift
+  ///
+  /// @return     Shifted region
+  [[nodiscard]] auto operator +(const Vector &shift) const -> Region;
+
+  auto operator |=(const Region &other) -> Region & {return *this = *this | other;}
+
+  auto operator &=(const Region &other) -> Region & {return *this = *this & other;}
+
+  auto operator -=(const Region &other) -> Region & {return *this = *this - other;}
+
+  ///
+  /// Determine whether region contains any cells
+  ///
+  /// @return     True if empty
+  [[nodiscard]] auto empty() const -> bool {return rectangles_.empty();}
+
+  ///
+  /// Get number of rectangles
+  ///
+  /// @return     Number of rectangles
+  [[nodiscard]] auto size() const -> size_t {return rectangles_.size();}
+
+  [[nodiscard]] auto begin() const {return rectangles_.begin();}
+
+  [[nodiscard]] auto end() const {return rectangles_.end();}
+
+  [[nodiscard]] auto rectangles() const -> const Rectangles & {return rectangles_;}
+
+  ///
+  /// Get bounding rectangle
+  ///
+  /// @return     Smallest rectangle containing the region
+  [[nodiscard]] auto bounds() const -> Rectangle;
+
+  ///
+  /// Determine whether region intersects rectangle
+  ///
+  /// @param[in]  rectangle  The rectangle
+  ///
+  /// @return     True if they have cells in common
+  [[nodiscard]] auto intersects(const Rectangle &rectangle) const -> bool;
+
+  private:
+  enum class Operation {union_, intersection, difference};
+
+  ///
+  /// Combine two regions band by band
+  ///
+  /// @param[in]  region1    Region 1
+  /// @param[in]  region2    Region 2
+  /// @param[in]  operation  The operation
+  ///
+  /// @return     Resulting region
+  static auto combine(const Region &region1, const Region &region2, Operation operation) -> Region;
+
+  Rectangles rectangles_; //< Banded rectangles
+};
+
+} // namespace jwezel
@@ -0,0 +1,162 @@
+#include "replay.hh"
+#include "geometry.hh"
+#include "term.hh"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace jwezel {
+
+using std::format;
+using
+  std::array,
+  std::runtime_error,
+  std::string_view,
+  std::system_category,
+  std::system_error;
+using std::chrono::microseconds, std::chrono::milliseconds, std::chrono::steady_clock;
+
+namespace
+{
+///
+/// Write all of string to file descriptor
+///
+/// @param[in]  output  The output file descriptor
+/// @param[in]  str     The string
+void writeAll(int output, string_view str) {
+  size_t wt{0};
+  while (wt < str.size()) {
+    auto wc{::write(output, str.data() + wt, str.size() - wt)}; // NOLINT
+    if (wc < 0) {
+      throw system_error(errno, system_category(), format("Could not write replay input to {}", output));
+    }
+    wt += wc;
+  }
+}
+
+///
+/// Get value of hex digit
+///
+/// @param[in]  digit  The digit
+///
+/// @return     Value
+auto hexValue(char digit) -> unsigned {
+  static const unsigned Ten{10};
+  if (digit >= '0' and digit <= '9') {
+    return digit - '0';
+  }
+  if (digit >= 'a' and digit <= 'f') {
+    return digit - 'a' + Ten;
+  }
+  throw runtime_error(format("Invalid hex digit '{}' in input recording", digit));
+}
+} // namespace
+
+Replay::Replay(int recording) {
+  static const size_t ChunkSize{65536};
+  string content;
+  array<char, ChunkSize> chunk{};
+  while (true) {
+    auto rc{::read(recording, chunk.data(), chunk.size())};
+    if (rc < 0) {
+      throw system_error(errno, system_category(), format("Could not read input recording from {}", recording));
+    }
+    if (rc == 0) {
+      break;
+    }
+    content.append(chunk.data(), rc);
+  }
+  size_t lineNumber{0};
+  for (size_t begin = 0, end = 0; begin < content.size(); begin = end + 1) {
+    ++lineNumber;
+    end = content.find('\n', begin);
+    if (end == string::npos) {
+      end = content.size();
+    }
+    const string_view line{string_view{content}.substr(begin, end - begin)};
+    const auto separator{line.find(' ')};
+    if (separator == string_view::npos or (line.size() - separator - 1) % 2 != 0) {
+      throw runtime_error(format("Invalid input recording line {}", lineNumber));
+    }
+    Input input{microseconds{std::stoll(string{line.substr(0, separator)})}, {}};
+    for (auto pos = separator + 1; pos < line.size(); pos += 2) {
+      input.bytes += static_cast<char>(hexValue(line[pos]) << 4U | hexValue(line[pos + 1]));
+    }
+    inputs_.push_back(std::move(input));
+  }
+}
+
+void Replay::start(int input, const Vector &size) {
+  // Replies to the cursor position requests of Display's constructor
+  writeAll(input, format("\x1b[1;1R\x1b[1;1R\x1b[{};{}R", size.y(), size.x()));
+}
+
+auto Replay::run(Terminal &terminal, int input, bool realTime) const -> vector<EventStatistics> {
+  static const milliseconds PollInterval{10};
+  vector<EventStatistics> result;
+  // Input is written by a thread, as a chunk may end within a sequence that
+  // only the next chunk completes
+  std::atomic<bool> written{false};
+  std::exception_ptr error;
+  std::thread writer{[this, input, realTime, &written, &error]() {
+    try {
+      const auto start{steady_clock::now()};
+      for (const auto &chunk: inputs_) {
+        if (realTime) {
+          std::this_thread::sleep_until(start + chunk.time);
+        }
+        writeAll(input, chunk.bytes);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    written = true;
+  }};
+  try {
+    while (true) {
+      if (!terminal.keyboard().pending()) {
+        // Check before polling, so input written last is not missed
+        const auto done{written.load()};
+        pollfd fd{terminal.keyboard().fd(), POLLIN, 0};
+        const auto ready{::poll(&fd, 1, done? 0: int(PollInterval.count()))};
+        if (ready < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw system_error(errno, system_category(), format("Could not poll keyboard {}", fd.fd));
+        }
+        if (ready == 0) {
+          if (done) {
+            break;
+          }
+          continue;
+        }
+      }
+      const auto output{terminal.display().written()};
+      const auto eventStart{steady_clock::now()};
+      terminal.runEvent();
+      result.push_back(EventStatistics{steady_clock::now() - eventStart, terminal.display().written() - output});
+    }
+  } catch (...) {
+    writer.join();
+    throw;
+  }
+  writer.join();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return result;
+}
+
+} // namespace jwezel
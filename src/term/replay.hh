@@ -0,0 +1,70 @@
+#pragma once
+
+#include "geometry.hh"
+#include "term.hh"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace jwezel {
+
+///
+/// Replay of recorded keyboard input
+///
+/// Feeds input recorded with Keyboard::record into a Terminal whose keyboard
+/// reads from a pipe, and measures how the terminal processes every event.
+struct Replay {
+  ///
+  /// Chunk of recorded input
+  struct Input {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::chrono::microseconds time; ///< Time since start of recording
+    string bytes;                   ///< Raw input
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+  };
+
+  ///
+  /// Processing statistics of an event
+  struct EventStatistics {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::chrono::steady_clock::duration time; ///< Processing time
+    size_t output;                            ///< Bytes written to the display
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+  };
+
+  ///
+  /// Load recording
+  ///
+  /// @param[in]  recording  Recording file descriptor
+  explicit Replay(int recording);
+
+  ///
+  /// Write terminal replies expected while constructing a Terminal
+  ///
+  /// Must be called before the Terminal is constructed on the read end of the pipe.
+  ///
+  /// @param[in]  input  Write end of the keyboard pipe
+  /// @param[in]  size   Simulated terminal size
+  static void start(int input, const Vector &size=Vector{80, 24});
+
+  ///
+  /// Replay recording
+  ///
+  /// The input is written from a thread, so chunks may end within a sequence.
+  /// Events are run until all input is written and processed.
+  ///
+  /// @param      terminal  The terminal
+  /// @param[in]  input     Write end of the keyboard pipe
+  /// @param[in]  realTime  Whether to keep the recorded timing (else replay as fast as possible)
+  ///
+  /// @return     Statistics of every event
+  auto run(Terminal &terminal, int input, bool realTime=false) const -> vector<EventStatistics>;
+
+  [[nodiscard]] auto inputs() const -> const auto & {return inputs_;}
+
+  private:
+  vector<Input> inputs_;
+};
+
+} // namespace jwezel
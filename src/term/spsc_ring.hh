@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace jwezel {
+
+///
+/// Bounded lock-free single-producer/single-consumer ring
+///
+/// push()/waitSpace() must only be called from one thread and pop()/wait() only
+/// from one (possibly different) thread.
+///
+/// @tparam     T         Element type (default constructible, movable)
+/// @tparam     Capacity  Number of slots (power of two)
+template<typename T, size_t Capacity>
+struct SpscRing {
+  static_assert(Capacity > 0 and (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  ///
+  /// Append value
+  ///
+  /// @param      value  The value (left untouched if the ring is full)
+  ///
+  /// @return     Whether the value was appended
+  auto push(T &&value) -> bool {
+    const auto head{head_.load(std::memory_order_relaxed)};
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    slots_[head & Mask] = std::move(value);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+    return true;
+  }
+
+  ///
+  /// Remove first value
+  ///
+  /// @return     The value, nothing if the ring is empty
+  auto pop() -> std::optional<T> {
+    const auto tail{tail_.load(std::memory_order_relaxed)};
+    if (head_.load(std::memory_order_acquire) == tail) {
+      return std::nullopt;
+    }
+    std::optional<T> result{std::move(slots_[tail & Mask])};
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+    return result;
+  }
+
+  ///
+  /// Block until the ring is not empty
+  void wait() const {
+    const auto tail{tail_.load(std::memory_order_relaxed)};
+    head_.wait(tail, std::memory_order_acquire);
+  }
+
+  ///
+  /// Block until the ring is not full
+  void waitSpace() const {
+    const auto head{head_.load(std::memory_order_relaxed)};
+    tail_.wait(head - Capacity, std::memory_order_acquire);
+  }
+
+  ///
+  /// Get number of values in the ring
+  ///
+  /// @return     Number of values (a snapshot when called concurrently)
+  [[nodiscard]] auto size() const -> size_t {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  private:
+  static constexpr size_t Mask{Capacity - 1};
+  static constexpr size_t CacheLine{64};
+
+  alignas(CacheLine) std::atomic<size_t> head_{0}; //< Next slot to write (producer)
+  alignas(CacheLine) std::atomic<size_t> tail_{0}; //< Next slot to read (consumer)
+  alignas(CacheLine) std::array<T, Capacity> slots_{};
+};
+
+} // namespace jwezel
@@ -1,4 +1,5 @@
 #include "geometry.hh"
+#include "region.hh"
 #include "surface.hh"
 #include "text.hh"
 #include "update.hh"
@@ -12,8 +13,6 @@
 #include <utility>
 #include <vector>
 
-#include <boost/geometry.hpp>
-
 namespace jwezel {
 
 using std::ranges::views::transform, std::ranges::views::filter;
@@ -24,30 +23,145 @@ namespace
 {
 
 ///
-/// Get non-intersecting parts from two ranges of fragments
+/// Get cells covered by fragments
+///
+/// @param[in]  fragments  The fragments
+///
+/// @return     Region of the fragments
+auto regionOf(const vector<Surface::Fragment> &fragments) -> Region {
+  vector<Rectangle> areas;
+  areas.reserve(fragments.size());
+  std::ranges::copy(fragments | transform(&Surface::Fragment::area), back_inserter(areas));
+  return Region(areas);
+}
+
+///
+/// Get fragments of element from region
+///
+/// @param[in]  region   The region
+/// @param[in]  element  The element
+///
+/// @return     Fragments ordered by top, then left edge
+auto fragmentsOf(const Region &region, Surface::Element *element) -> vector<Surface::Fragment> {
+  vector<Surface::Fragment> result;
+  result.reserve(region.size());
+  for (const auto &area: region) {
+    result.emplace_back(area, element);
+  }
+  return result;
+}
+
+///
+/// Remove parts of fragments covered by other fragments
 ///
 /// @param[in]  area        The area
 /// @param      fragments1  The fragments 1
 /// @param[in]  fragments2  The fragments 2
 void split(const Rectangle & area, vector<Surface::Fragment> &fragments1, const vector<Surface::Fragment> &fragments2) {
-  auto *element{fragments1[0].element};
+  if (fragments1.empty()) {
+    return;
+  }
+  auto region{regionOf(fragments1)};
+  bool covered{false};
   for (const auto &fragment2: fragments2) {
-    if (area.intersects(fragment2.area)) {
-      vector<Surface::Fragment> fragments;
-      for (const auto &fragment1: fragments1) {
-        const auto intersection{fragment1.area.defaultIntersection(fragment2.area)};
-        std::ranges::copy(
-          intersection | transform([element](const Rectangle &r){return Surface::Fragment(r, element);}),
-          back_inserter(fragments)
-        );
-      }
-      fragments1 = fragments;
+    if (area.intersects(fragment2.area) and region.intersects(fragment2.area)) {
+      region -= Region(fragment2.area);
+      covered = true;
     }
   }
+  if (covered) {
+    fragments1 = fragmentsOf(region, fragments1[0].element);
+  }
 }
 
-void cover(Surface::Element &element1, const Surface::Element &element2) {
-  split(element1.area(), element1.fragments(), element2.fragments());
+///
+/// Join row spans into fragments
+///
+/// Rows must be added top to bottom. Adjacent spans of the same element in a
+/// row are joined, as are equal spans of the same element in adjacent rows.
+struct FragmentBuilder {
+  ///
+  /// Start row
+  ///
+  /// @param[in]  y1    Top of row
+  /// @param[in]  y2    Bottom of row
+  void row(Dim y1, Dim y2) {
+    flush();
+    y1_ = y1;
+    y2_ = y2;
+  }
+
+  ///
+  /// Add span to current row
+  ///
+  /// @param[in]  x1       Start of span
+  /// @param[in]  x2       End of span
+  /// @param[in]  element  The element
+  void add(Dim x1, Dim x2, Surface::Element *element) {
+    if (!spans_.empty() and spans_.back().element == element and spans_.back().x2 == x1) {
+      spans_.back().x2 = x2;
+    } else {
+      spans_.push_back(Span{x1, x2, element});
+    }
+  }
+
+  ///
+  /// Get fragments
+  ///
+  /// @return     Fragments ordered by top, then left edge
+  auto fragments() -> vector<Surface::Fragment> {
+    flush();
+    std::ranges::move(open_, back_inserter(done_));
+    open_.clear();
+    std::ranges::sort(done_, [](const Surface::Fragment &lhs, const Surface::Fragment &rhs) {
+      return lhs.area.y1() < rhs.area.y1() or lhs.area.y1() == rhs.area.y1() and lhs.area.x1() < rhs.area.x1();
+    });
+    return std::move(done_);
+  }
+
+  private:
+  struct Span {
+    Dim x1;
+    Dim x2;
+    Surface::Element *element;
+  };
+
+  void flush() {
+    vector<Surface::Fragment> open;
+    for (const auto &span: spans_) {
+      const auto continued{std::ranges::find_if(open_, [this, &span](const Surface::Fragment &fragment) {
+        return
+          fragment.area.y2() == y1_ and fragment.element == span.element and
+          fragment.area.x1() == span.x1 and fragment.area.x2() == span.x2;
+      })};
+      if (continued == open_.end()) {
+        open.emplace_back(Rectangle{span.x1, y1_, span.x2, y2_}, span.element);
+      } else {
+        open.emplace_back(Rectangle{span.x1, continued->area.y1(), span.x2, y2_}, span.element);
+        continued->element = 0;
+      }
+    }
+    std::ranges::copy_if(open_, back_inserter(done_), [](const Surface::Fragment &fragment) {return fragment.element;});
+    open_ = std::move(open);
+    spans_.clear();
+  }
+
+  vector<Span> spans_;                //< Spans of current row
+  vector<Surface::Fragment> open_;    //< Fragments ending at the current row
+  vector<Surface::Fragment> done_;    //< Complete fragments
+  Dim y1_{0};
+  Dim y2_{0};
+};
+
+///
+/// Get rows covered by ownership map row
+///
+/// @param[in]  row   The row index
+/// @param[in]  rows  Number of rows in the map
+///
+/// @return     Top and bottom
+auto ownerRowBounds(size_t row, size_t rows) -> pair<Dim, Dim> {
+  return {static_cast<Dim>(row), row + 1 == rows? DimHigh: static_cast<Dim>(row + 1)};
 }
 
 } // namespace
@@ -76,22 +190,42 @@ surface_{surface}
 
 Surface::Element::~Element() = default;
 
-void Surface::Element::update(const vector<Rectangle> &areas) {
-  vector<Fragment> updates;
-  for (const auto &fragment: fragments_) {
-    for (const auto &area_: areas) {
-      const auto update_{fragment.area & area_ + area().position()};
-      if (update_) {
-        updates.emplace_back(update_.value(), this);
-      }
+auto Surface::Element::fragments() const -> vector<Fragment> {
+  vector<Fragment> result;
+  result.reserve(fragments_.size());
+  for (const auto handle: fragments_) {
+    result.push_back(surface_->fragmentPool_[handle]);
+  }
+  return result;
+}
+
+void Surface::Element::update(const Region &areas) {
+  if (!visible()) {
+    return;
+  }
+  if (surface_->deferUpdates_) {
+    if (areas.empty()) {
+      return;
+    }
+    if (dirty_.empty()) {
+      surface_->dirty_.push_back(this);
     }
+    dirty_ |= areas;
+    return;
   }
-  surface_->update(updates);
+  surface_->update(damage(areas));
 }
 
 void Surface::Element::update(const Rectangle &area_) {
+  if (!visible()) {
+    return;
+  }
+  if (surface_->deferUpdates_ or surface_->transactions_) {
+    update(Region(area_));
+    return;
+  }
   vector<Fragment> updates;
-  for (const auto &fragment: fragments_) {
+  for (const auto &fragment: fragments()) {
     const auto update_{fragment.area & area_ + area().position()};
     if (update_) {
       updates.emplace_back(update_.value(), this);
@@ -100,6 +234,40 @@ void Surface::Element::update(const Rectangle &area_) {
   surface_->update(updates);
 }
 
+void Surface::Element::shift(const Rectangle &area, const Vector &offset) {
+  if (!visible()) {
+    return;
+  }
+  // Held back updates would make the device content stale
+  if (dirty_.intersects(area)) {
+    update(Region(area));
+    return;
+  }
+  const auto origin{this->area().position()};
+  const auto visibleArea{Region(area + origin) & surface_->onDevice(this)};
+  const auto kept{visibleArea & (visibleArea + offset)};
+  if (kept.empty() or !surface_->moveOnDevice(kept, offset)) {
+    update(Region(area));
+    return;
+  }
+  update((Region(area + origin) - kept) + (Vector{0, 0} - origin));
+}
+
+auto Surface::Element::damage(const Region &areas) -> vector<Fragment> {
+  const auto shifted{areas + area().position()};
+  if (surface_->transactions_) {
+    // Fragments are those of the last commit
+    return fragmentsOf(shifted & Region(area()), this);
+  }
+  vector<Fragment> result;
+  for (const auto &fragment: fragments()) {
+    if (shifted.intersects(fragment.area)) {
+      std::ranges::copy(fragmentsOf(shifted & Region(fragment.area), this), back_inserter(result));
+    }
+  }
+  return result;
+}
+
 void Surface::Element::move(const Rectangle &area) {
   surface()->reshapeElement(this, area);
 }
@@ -117,54 +285,112 @@ device_{device}
 }
 
 void Surface::update(const vector<Fragment> &updates) {
-  device_->update(SurfaceUpdates(updates));
-}
-
-void Surface::removeRtreeFragments(Surface::Element &element) {
-  for (auto &fragment: element.fragments()) {
-    rtree.remove(std::make_pair(fragment.area, &fragment));
+  if (transactions_) {
+    damage_ |= regionOf(updates);
+    return;
+  }
+  const auto shown{device_->area()};
+  vector<Fragment> texts;
+  texts.reserve(updates.size());
+  for (const auto &update: updates) {
+    const auto area{update.area & shown};
+    if (!area) {
+      continue;
+    }
+    const Fragment fragment{area.value(), update.element};
+    const auto fill{fragment.element->uniform(fragment.area - fragment.element->area().position())};
+    if (!fill or !device_->fill(fragment.area, fill.value())) {
+      texts.push_back(fragment);
+    }
   }
+  device_->update(SurfaceUpdates(texts));
 }
 
-void Surface::insertRtreeFragments(Surface::Element &element) {
-  for (auto &fragment: element.fragments()) {
-    rtree.insert(std::make_pair(fragment.area, &fragment));
+void Surface::assignFragments(Element &element, const vector<Fragment> &fragments) {
+  const auto origin{[this](FragmentHandle handle) {
+    const auto &area{fragmentPool_[handle].area};
+    return pair{area.y1(), area.x1()};
+  }};
+  auto previous{element.fragments_};
+  std::ranges::sort(previous, {}, origin);
+  vector<FragmentHandle> handles(fragments.size(), 0);
+  vector<size_t> added;
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    const auto &area{fragments[i].area};
+    const auto found{std::ranges::lower_bound(previous, pair{area.y1(), area.x1()}, {}, origin)};
+    if (found != previous.end() and fragmentPool_[*found].area == area) {
+      handles[i] = *found;
+      previous.erase(found);
+    } else {
+      added.push_back(i);
+    }
+  }
+  for (const auto handle: previous) {
+    index_->remove(fragmentPool_[handle].area, handle);
+    freeFragments_.push_back(handle);
+  }
+  for (const auto i: added) {
+    if (freeFragments_.empty()) {
+      handles[i] = FragmentHandle(fragmentPool_.size());
+      fragmentPool_.push_back(fragments[i]);
+    } else {
+      handles[i] = freeFragments_.back();
+      freeFragments_.pop_back();
+      fragmentPool_[handles[i]] = fragments[i];
+    }
+    index_->insert(fragments[i].area, handles[i]);
   }
+  element.fragments_ = std::move(handles);
 }
 
 void Surface::cover(long pos) {
   auto *element{zorder_[pos]};
-  element->fragments_ = {Surface::Fragment{element->area(), element}};
-  for (unsigned j = pos + 1; j < zorder_.size(); ++j) {
-    jwezel::cover(*element, *zorder_[j]);
+  Region visible{element->area()};
+  for (auto j = size_t(pos) + 1; j < zorder_.size() and !visible.empty(); ++j) {
+    if (visible.intersects(zorder_[j]->area())) {
+      visible -= Region(zorder_[j]->area());
+    }
   }
+  assignFragments(*element, fragmentsOf(visible, element));
 }
 
 void Surface::addElement(Surface::Element *element, Surface::Element *below) {
   // Add element to surface
-  const auto insertPos =
-    below?
-      std::find(zorder_.begin(), zorder_.end(), below)
-    :
-      zorder_.end();
-  const auto ze{std::distance(zorder_.begin(), zorder_.insert(insertPos, element))};
+  const auto ze{long(below? position(below): zorder_.size())};
+  zorder_.insert(zorder_.begin() + ze, element);
+  renumber(ze, zorder_.size());
+  if (transactions_) {
+    restructured_ |= Region(element->area());
+    if (ze) {
+      damage_ |= Region(element->area());
+    }
+    return;
+  }
+  if (compositor_ == Compositor::ownershipMap) {
+    assignFragments(*element, {});
+    const auto updates{recompose(element->area())};
+    if (ze) {
+      update(updates);
+    }
+    return;
+  }
   // Create own fragments from overlaying fragments when inserting it below the top
   cover(ze);
   // Create fragments of all elements overlayed by this
+  const auto covering{element->fragments()};
   for (auto z = ze - 1; z >= 0; --z) {
     auto * const elementBelow = zorder_[z];
     if (elementBelow->area().intersects(element->area())) {
-      removeRtreeFragments(*elementBelow);
-      jwezel::cover(*elementBelow, *element);
-      insertRtreeFragments(*elementBelow);
+      auto fragments{elementBelow->fragments()};
+      split(elementBelow->area(), fragments, covering);
+      assignFragments(*elementBelow, fragments);
     }
   }
   // TODO(j): Find a better way to test for the backdrop. Creating a device update
   // for the backdrop is not necessary and creates problems
   if (ze) {
-    update(element->fragments_);
+    update(covering);
   }
-  insertRtreeFragments(*element);
 }
 
 auto Surface::position(Element *element, int default_) -> int {
@@ -174,11 +400,20 @@ auto Surface::position(Element *element, int default_) -> int {
     }
     return default_;
   }
-  const auto zit{std::find(zorder_.begin(), zorder_.end(), element)};
-  if (zit == zorder_.end()) {
+  if (!contains(element)) {
     throw domain_error(format("Element {} not found in zorder\n", static_cast<const void*>(element)));
   }
-  return std::distance(zorder_.begin(), zit); // NOLINT
+  return int(element->zindex_);
+}
+
+auto Surface::contains(const Element *element) const -> bool {
+  return element->zindex_ < zorder_.size() and zorder_[element->zindex_] == element;
+}
+
+void Surface::renumber(size_t first, size_t end) {
+  for (auto pos = first; pos < end; ++pos) {
+    zorder_[pos]->zindex_ = pos;
+  }
 }
 
 void Surface::deleteElement(Element *element, Element *destination) {
@@ -187,18 +422,41 @@ void Surface::deleteElement(Element *element, Element *destination) {
   const auto ze{position(element)};
   const auto zb{position(destination, 0)};
   // Remove element from surface
-  removeRtreeFragments(*element);
+  assignFragments(*element, {});
   zorder_.erase(zorder_.begin() + ze);
+  renumber(ze, zorder_.size());
+  if (!element->dirty_.empty()) {
+    std::erase(dirty_, element);
+    element->dirty_ = {};
+  }
+  if (transactions_) {
+    damage_ |= Region(element->area());
+    restructured_ |= Region(element->area());
+    if (compositor_ == Compositor::ownershipMap) {
+      // The element may be gone by the commit
+      const auto [first, end]{ownerRows(element->area())};
+      for (auto row = first; row < end; ++row) {
+        for (auto &span: owners_[row]) {
+          if (span.owner == element) {
+            span.owner = nullptr;
+          }
+        }
+      }
+    }
+    return;
+  }
+  if (compositor_ == Compositor::ownershipMap) {
+    update(recompose(element->area()));
+    return;
+  }
   // Recreate fragments covered by removed element
   for (auto z1 = ze - 1; z1 >= zb; --z1) {
     Element * const zelement = zorder_[z1];
     if (zelement->area().intersects(element->area())) {
-      removeRtreeFragments(*zelement);
       cover(z1);
-      insertRtreeFragments(*zelement);
       // Add surface updates for these fragments
       std::ranges::copy(
-        zelement->fragments_ |
+        zelement->fragments() |
         transform([element](const Surface::Fragment &f) {return f.area & element->area();}) |
         filter([](const std::optional<Rectangle> &r) {return r.has_value();}) |
         transform([zelement](const std::optional<Rectangle> &r){return Surface::Fragment{r.value(), zelement};}),
@@ -212,48 +470,140 @@ void Surface::deleteElement(Element *element, Element *destination) {
 void Surface::reshapeElement(Element *element, const Rectangle &area) { //NOLINT(readability-function-cognitive-complexity)
   vector<Fragment> updates;
   if (element->area() != area) {
-    const auto zpos = std::find(zorder_.begin(), zorder_.end(), element);
-    if (zpos == zorder_.end()) {
+    if (!contains(element)) {
       throw range_error(format("Element {} not found", static_cast<void*>(element)));
     }
-    const auto ze = std::distance(zorder_.begin(), zpos);
+    const auto ze{long(element->zindex_)};
     if (ze == 0) {
       throw logic_error("Lowest element must be the 'backdrop', which must not be moved");
     }
-    auto damageAreas{element->area().defaultIntersection(area)};
-    damageAreas.push_back(area);
-    auto const searchArea = element->area() | area;
+    const auto previousArea{element->area()};
+    const auto previousVisible{onDevice(element)};
     element->moveEvent(area);
-    // Recreate fragments
-    for (auto j = ze; j >= 0; --j) {
-      auto * const element_ = zorder_[j];
-      if (element_->area().intersects(searchArea)) {
-        removeRtreeFragments(*element_);
-        // Create fragments from elements on top of it
-        cover(j);
-        insertRtreeFragments(*element_);
-        // Surface update fragments
-        for (const auto &fragment: element_->fragments_) {
-          for (const auto &damageArea: damageAreas) {
-            auto const intersection = fragment.area & damageArea;
-            if (intersection) {
-              updates.emplace_back(intersection.value(), element_);
-            }
-          }
+    if (transactions_) {
+      damage_ |= Region{previousArea, area};
+      restructured_ |= Region{previousArea, area};
+      if (area.size() == previousArea.size()) {
+        // Content staying visible is moved on the device by the commit
+        const auto offset{area.position() - previousArea.position()};
+        const auto destinations{(previousVisible + offset) & uncovered(element) & Region(device_->area())};
+        if (!destinations.empty()) {
+          (void)moveOnDevice(destinations, offset);
+          damage_ -= destinations;
         }
       }
+      return;
+    }
+    if (compositor_ == Compositor::ownershipMap) {
+      // Moved or resized content of the element needs an update where ownership is unchanged
+      const auto owners{recompose(previousArea | area)};
+      std::ranges::copy(moved(element, previousArea, previousVisible), back_inserter(updates));
+      std::ranges::copy_if(owners, back_inserter(updates), [element](const Fragment &f) {return f.element != element;});
+      update(updates);
+      return;
+    }
+    // Recreate fragments of the element itself
+    cover(ze);
+    updates = moved(element, previousArea, previousVisible);
+    // Lower elements only change where the element was or is now. As the
+    // element covers its new area, what they reveal is in the previous area.
+    const Region changedAreas{previousArea, area};
+    for (auto j = ze - 1; j >= 0; --j) {
+      auto * const element_ = zorder_[j];
+      if (element_->area().intersects(previousArea) or element_->area().intersects(area)) {
+        std::ranges::copy(recover(j, changedAreas), back_inserter(updates));
+      }
     }
   }
   update(updates);
 }
 
+auto Surface::moved(Element *element, const Rectangle &previousArea, const Region &previousVisible) -> vector<Fragment> {
+  auto fragments{element->fragments()};
+  const auto area{element->area()};
+  if (area.size() != previousArea.size()) {
+    return fragments;
+  }
+  const auto offset{area.position() - previousArea.position()};
+  const auto visible{regionOf(fragments)};
+  const auto shifted{(previousVisible + offset) & visible & Region(device_->area())};
+  if (shifted.empty() or !moveOnDevice(shifted, offset)) {
+    return fragments;
+  }
+  return fragmentsOf(visible - shifted, element);
+}
+
+auto Surface::uncovered(const Element *element) const -> Region {
+  auto result{Region(element->area())};
+  for (auto z = element->zindex_ + 1; z < zorder_.size() and !result.empty(); ++z) {
+    if (result.intersects(zorder_[z]->area())) {
+      result -= Region(zorder_[z]->area());
+    }
+  }
+  return result;
+}
+
+auto Surface::onDevice(const Element *element) const -> Region {
+  // Deferred updates are not on the device yet
+  const auto stale{element->dirty_ + element->area().position()};
+  if (transactions_) {
+    return (uncovered(element) - damage_ - stale) & Region(device_->area());
+  }
+  return (regionOf(element->fragments()) - stale) & Region(device_->area());
+}
+
+auto Surface::moveOnDevice(const Region &destinations, const Vector &offset) -> bool {
+  if (transactions_) {
+    moves_.emplace_back(destinations, offset);
+    return true;
+  }
+  const auto sources{destinations + (Vector{0, 0} - offset)};
+  return device_->move(vector<Rectangle>(sources.begin(), sources.end()), offset);
+}
+
+auto Surface::recover(long pos, const Region &areas) -> vector<Fragment> {
+  auto *element{zorder_[pos]};
+  // Create fragments inside of areas from elements on top of it
+  auto revealed{Region(element->area()) & areas};
+  for (auto z = size_t(pos) + 1; z < zorder_.size() and !revealed.empty(); ++z) {
+    if (revealed.intersects(zorder_[z]->area())) {
+      revealed -= Region(zorder_[z]->area());
+    }
+  }
+  // Keep fragments outside of areas
+  assignFragments(*element, fragmentsOf((regionOf(element->fragments()) - areas) | revealed, element));
+  return fragmentsOf(revealed, element);
+}
+
 void Surface::reorder(int source, int destination) {
   vector<Fragment> updates;
+  // Positions from the lower of source and destination up to the higher one change
+  const auto renumbered{[this, first = std::min(source, destination), end = std::max(source, destination) + 1]() {
+    renumber(first, std::min(size_t(end), zorder_.size()));
+  }};
+  if (transactions_ or compositor_ == Compositor::ownershipMap) {
+    auto *element{zorder_[source]};
+    if (destination < source) {
+      std::shift_right(zorder_.begin() + destination, zorder_.begin() + source + 1, 1);
+    } else {
+      std::shift_left(zorder_.begin() + source, zorder_.begin() + destination--, 1);
+    }
+    zorder_[destination] = element;
+    renumbered();
+    if (transactions_) {
+      damage_ |= Region(element->area());
+      restructured_ |= Region(element->area());
+    } else {
+      update(recompose(element->area()));
+    }
+    return;
+  }
   if (destination < source) {
     // Move down
     auto *element{zorder_[source]};
     std::shift_right(zorder_.begin() + destination, zorder_.begin() + source + 1, 1);
     zorder_[destination] = element;
+    renumbered();
     auto const searchArea = zorder_[destination]->area();
     // Recreate fragments
     for (auto j = source; j >= destination; --j) {
@@ -261,12 +611,10 @@ void Surface::reorder(int source, int destination) {
       auto elementIntersection{element_->area() & searchArea};
       if (elementIntersection) {
         // Create fragments from elements on top of it
-        removeRtreeFragments(*element_);
         cover(j);
-        insertRtreeFragments(*element_);
         if (element_ != zorder_[destination]) {
           // Surface update fragments
-          for (const auto &fragment: element_->fragments_) {
+          for (const auto &fragment: element_->fragments()) {
             auto const intersection = fragment.area & elementIntersection.value();
             if (intersection) {
               updates.emplace_back(intersection.value(), element_);
@@ -280,19 +628,18 @@ void Surface::reorder(int source, int destination) {
     auto *element{zorder_[source]};
     std::shift_left(zorder_.begin() + source, zorder_.begin() + destination--, 1);
     zorder_[destination] = element;
-    auto oldFragments = element->fragments_;
+    renumbered();
+    auto oldFragments = element->fragments();
     auto const searchArea = zorder_[destination]->area();
     for (auto j = destination; j >= source; --j) {
       auto * const element_ = zorder_[j];
       auto elementIntersection{element_->area() & searchArea};
       if (elementIntersection) {
         // Create fragments from elements on top of it
-        removeRtreeFragments(*element_);
         cover(j);
-        insertRtreeFragments(*element_);
         if (element_ != zorder_[destination]) {
           // Surface update fragments
-          for (const auto &fragment: element_->fragments_) {
+          for (const auto &fragment: element_->fragments()) {
             auto const intersection = fragment.area & elementIntersection.value();
             if (intersection) {
               updates.emplace_back(intersection.value(), element_);
@@ -302,7 +649,7 @@ void Surface::reorder(int source, int destination) {
       }
     }
     // Surface updates
-    updates = element->fragments_;
+    updates = element->fragments();
     split(element->area(), updates, oldFragments);
   }
   update(updates);
@@ -334,19 +681,255 @@ auto Surface::minSize(const Element *exclude) const -> Vector {
   return result;
 }
 
-auto Surface::find(const Vector &position) const -> Fragment * {
-  vector<RtreeEntry> result;
-  rtree.query(boost::geometry::index::contains(Rectangle{position, position + Vector{1, 1}}), std::back_inserter(result));
-  switch (result.size()) {
-    case 0:
-    return 0;
+auto Surface::find(const Vector &position) const -> const Fragment * {
+  const auto handle{index_->find(position)};
+  return handle? &fragmentPool_[handle.value()]: 0;
+}
 
-    case 1:
-    return result[0].second;
+void Surface::compositor(Compositor compositor) {
+  if (compositor == compositor_) {
+    return;
+  }
+  compositor_ = compositor;
+  for (auto *element: zorder_) {
+    assignFragments(*element, {});
+  }
+  if (compositor_ == Compositor::ownershipMap) {
+    owners_ = {OwnerRow{OwnerSpan{0, DimHigh, 0}}};
+    for (auto *element: zorder_) {
+      extendOwners(element->area());
+    }
+    (void)recompose(RectangleMax);
+  } else {
+    // Fragments are split against the fragments of the elements above
+    for (auto pos = long(zorder_.size()) - 1; pos >= 0; --pos) {
+      cover(pos);
+    }
+  }
+}
 
-    default:
-    throw std::logic_error(format("Found {} results. Expected only one", result.size()));
+void Surface::spatialIndex(SpatialIndex index) {
+  if (index == spatialIndex_) {
+    return;
+  }
+  spatialIndex_ = index;
+  if (index == SpatialIndex::grid) {
+    index_ = std::make_unique<GridIndex>();
+  } else {
+    index_ = std::make_unique<RtreeIndex>();
   }
+  for (const auto *element: zorder_) {
+    for (const auto handle: element->fragments_) {
+      index_->insert(fragmentPool_[handle].area, handle);
+    }
+  }
+}
+
+void Surface::beginTransaction() {
+  ++transactions_;
+}
+
+void Surface::commit() {
+  if (!transactions_) {
+    throw logic_error("No transaction to commit");
+  }
+  if (--transactions_ or (damage_.empty() and moves_.empty() and restructured_.empty())) {
+    return;
+  }
+  auto damage{std::exchange(damage_, Region{})};
+  // Moves are replayed in order, as later ones may take content from earlier
+  // ones. Once the device fails one, the rest is updated.
+  const Region shown{device_->area()};
+  auto failed{false};
+  for (const auto &[destinations, offset]: std::exchange(moves_, {})) {
+    // The device may have been resized meanwhile
+    const auto possible{destinations & shown & (shown + offset)};
+    const auto sources{possible + (Vector{0, 0} - offset)};
+    failed = failed or (!possible.empty() and !device_->move(vector<Rectangle>(sources.begin(), sources.end()), offset));
+    damage |= failed? destinations: destinations - possible;
+  }
+  // Fragments are only recomputed where elements were added, deleted, reshaped or restacked
+  const auto restructured{std::exchange(restructured_, Region{})};
+  if (!restructured.empty()) {
+    if (compositor_ == Compositor::ownershipMap) {
+      const auto bounds{restructured.bounds()};
+      extendOwners(bounds);
+      (void)recompose(bounds);
+      // Elements may have changed without a change of ownership, for instance
+      // when one is deleted and another one created at the same address
+      for (auto *element: zorder_) {
+        if (restructured.intersects(element->area())) {
+          assignFragments(*element, ownedFragments(element));
+        }
+      }
+    } else {
+      for (size_t pos = 0; pos < zorder_.size(); ++pos) {
+        if (restructured.intersects(zorder_[pos]->area())) {
+          (void)recover(long(pos), restructured);
+        }
+      }
+    }
+  }
+  // Damaged content is painted from the fragments it meets
+  vector<Fragment> updates;
+  for (const auto &area: damage) {
+    for (const auto handle: index_->find(area)) {
+      const auto &fragment{fragmentPool_[handle]};
+      updates.emplace_back((fragment.area & area).value(), fragment.element);
+    }
+  }
+  update(updates);
+}
+
+void Surface::deferUpdates(bool defer) {
+  deferUpdates_ = defer;
+  if (!defer) {
+    flush();
+  }
+}
+
+void Surface::flush() {
+  if (dirty_.empty()) {
+    return;
+  }
+  vector<Fragment> updates;
+  for (auto *element: std::exchange(dirty_, {})) {
+    std::ranges::copy(element->damage(std::exchange(element->dirty_, Region{})), back_inserter(updates));
+  }
+  update(updates);
+}
+
+Surface::Transaction::Transaction(Surface &surface):
+surface_{surface}
+{
+  surface_.beginTransaction();
+}
+
+Surface::Transaction::~Transaction() {
+  try {
+    surface_.commit();
+  } catch (std::exception &error) {
+    std::cerr << error.what() << '\n';
+  }
+}
+
+//~Ownership map~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto Surface::ownerRows(const Rectangle &area) const -> pair<size_t, size_t> {
+  const auto last{owners_.size() - 1};
+  const auto y1{std::max(area.y1(), Dim{0})};
+  if (area.y2() <= y1) {
+    return {0, 0};
+  }
+  return {
+    std::min(size_t(y1), last),
+    size_t(area.y2()) > last? owners_.size(): size_t(area.y2())
+  };
+}
+
+void Surface::paint(OwnerRow &row, Dim x1, Dim x2, Element *owner) {
+  x1 = std::max(x1, Dim{0});
+  if (x1 >= x2) {
+    return;
+  }
+  OwnerRow result;
+  result.reserve(row.size() + 2);
+  const auto append{[&result](Dim spanX1, Dim spanX2, Element *spanOwner) {
+    if (spanX1 >= spanX2) {
+      return;
+    }
+    if (!result.empty() and result.back().owner == spanOwner and result.back().x2 == spanX1) {
+      result.back().x2 = spanX2;
+    } else {
+      result.push_back(OwnerSpan{spanX1, spanX2, spanOwner});
+    }
+  }};
+  for (const auto &span: row) {
+    if (span.x2 <= x1 or span.x1 >= x2) {
+      append(span.x1, span.x2, span.owner);
+    } else {
+      append(span.x1, std::min(span.x2, x1), span.owner);
+      if (span.x1 <= x1) {
+        append(x1, x2, owner);
+      }
+      append(std::max(span.x1, x2), span.x2, span.owner);
+    }
+  }
+  row = std::move(result);
+}
+
+void Surface::extendOwners(const Rectangle &area) {
+  // Rows below the lowest edge of all elements are equal and represented by the last row
+  const auto bound{size_t(std::max({Dim{0}, area.y1(), area.y2() == DimHigh? Dim{0}: area.y2()}))};
+  if (bound >= owners_.size()) {
+    owners_.insert(owners_.end() - 1, bound + 1 - owners_.size(), owners_.back());
+  }
+}
+
+auto Surface::recompose(const Rectangle &area) -> vector<Fragment> {
+  extendOwners(area);
+  const auto [first, end]{ownerRows(area)};
+  vector<Element *> candidates;
+  std::ranges::copy_if(zorder_, back_inserter(candidates), [&area](const Element *element) {
+    const auto elementArea{element->area()};
+    return elementArea.y1() < area.y2() and elementArea.y2() > area.y1();
+  });
+  FragmentBuilder damage;
+  vector<Element *> changed;
+  const auto changes{[&changed](Element *element) {
+    if (element and std::ranges::find(changed, element) == changed.end()) {
+      changed.push_back(element);
+    }
+  }};
+  for (auto row = first; row < end; ++row) {
+    const auto [y1, y2]{ownerRowBounds(row, owners_.size())};
+    OwnerRow owners{OwnerSpan{0, DimHigh, 0}};
+    for (auto *element: candidates) {
+      const auto elementArea{element->area()};
+      if (elementArea.y1() <= y1 and y1 < elementArea.y2()) {
+        paint(owners, elementArea.x1(), elementArea.x2(), element);
+      }
+    }
+    // Compare with previous ownership
+    damage.row(y1, y2);
+    const auto &previous{owners_[row]};
+    for (size_t i = 0, j = 0; i < previous.size() and j < owners.size();) {
+      const auto x1{std::max(previous[i].x1, owners[j].x1)};
+      const auto x2{std::min(previous[i].x2, owners[j].x2)};
+      if (previous[i].owner != owners[j].owner) {
+        changes(previous[i].owner);
+        changes(owners[j].owner);
+        if (owners[j].owner) {
+          damage.add(x1, x2, owners[j].owner);
+        }
+      }
+      i += previous[i].x2 == x2;
+      j += owners[j].x2 == x2;
+    }
+    owners_[row] = std::move(owners);
+  }
+  for (auto *element: changed) {
+    // Elements removed from the surface only serve for comparison
+    if (contains(element)) {
+      assignFragments(*element, ownedFragments(element));
+    }
+  }
+  return damage.fragments();
+}
+
+auto Surface::ownedFragments(Element *element) const -> vector<Fragment> {
+  FragmentBuilder result;
+  const auto [first, end]{ownerRows(element->area())};
+  for (auto row = first; row < end; ++row) {
+    const auto [y1, y2]{ownerRowBounds(row, owners_.size())};
+    result.row(y1, y2);
+    for (const auto &span: owners_[row]) {
+      if (span.owner == element) {
+        result.add(span.x1, span.x2, element);
+      }
+    }
+  }
+  return result.fragments();
 }
 
 //~TextElement~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -377,13 +960,24 @@ auto TextElement::write(const Vector &position, const string_view &str) -> TextE
 }
 
 auto TextElement::write(const Vector &position, const Text &txt_) -> TextElement & {
-  text_.patch(txt_, position);
-  update({Rectangle{position, position + txt_.size()}});
+  // Rewriting unchanged content costs only the comparison
+  if (const auto changed{text_.patch(txt_, position)}) {
+    update({changed.value()});
+  }
   return *this;
 }
 
 auto TextElement::fill(const Char &fillChar, const Rectangle &area) -> TextElement & {
-  update({text_.fill(fillChar, area)});
+  if (const auto changed{text_.fill(fillChar, area)}) {
+    update({changed.value()});
+  }
+  return *this;
+}
+
+auto TextElement::scroll(const Rectangle &area, Dim lines) -> TextElement & {
+  if (const auto scrolled{text_.scroll(area, lines, background())}) {
+    shift(scrolled.value(), Vector{0, Dim(-lines)});
+  }
   return *this;
 }
 
@@ -393,7 +987,7 @@ auto TextElement::line(const Line &line, u1 strength, u1 dash, bool roundedCorne
 }
 
 auto TextElement::box(const Box &box) -> TextElement & {
-  update(text_.box(box));
+  update(Region(text_.box(box)));
   return *this;
 }
 
@@ -435,4 +1029,47 @@ auto TextElement::text(const Rectangle &area) const -> Text {
   return text_[area];
 }
 
+//~ProceduralElement~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+ProceduralElement::ProceduralElement(Surface *surface, const Rectangle &area, Renderer renderer, Surface::Element *below):
+Element{surface},
+area_{area},
+renderer_{std::move(renderer)}
+{
+  surface->addElement(this, below);
+}
+
+ProceduralElement::~ProceduralElement() {
+  try {
+    surface()->deleteElement(this);
+  } catch (std::exception & error) {
+    std::cerr << error.what() << '\n';
+  }
+}
+
+void ProceduralElement::renderer(Renderer renderer) {
+  renderer_ = std::move(renderer);
+  invalidate();
+}
+
+void ProceduralElement::invalidate(const Rectangle &area) {
+  const auto visible{area & Rectangle{Vector{0, 0}, area_.size()}};
+  if (visible) {
+    update(Region(visible.value()));
+  }
+}
+
+auto ProceduralElement::moveEvent(const Rectangle &area) -> bool {
+  area_ = area;
+  return true;
+}
+
+auto ProceduralElement::text(const Rectangle &area) const -> Text {
+  const auto visible{area & Rectangle{Vector{0, 0}, area_.size()}};
+  if (!visible) {
+    return Text{};
+  }
+  return renderer_(visible.value());
+}
+
 } // namespace jwezel
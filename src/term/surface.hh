@@ -2,23 +2,14 @@
 
 #include <iostream>
 #include <term/device.hh>
+#include <term/fragment_index.hh>
 #include <term/geometry.hh>
+#include <term/region.hh>
 #include <term/text.hh>
 
-#include <boost/geometry/geometries/box.hpp>
-#include <boost/geometry/geometries/point.hpp>
-#include <boost/geometry/geometries/register/box.hpp>
-#include <boost/geometry/geometries/register/point.hpp>
-#include <boost/geometry/index/rtree.hpp>
+#include <functional>
 #include <initializer_list>
-
-// NOLINTBEGIN
-BOOST_GEOMETRY_REGISTER_POINT_2D(jwezel::Vector, jwezel::Dim, cs::cartesian, x(), y());
-BOOST_GEOMETRY_REGISTER_BOX_2D_4VALUES(jwezel::Rectangle, jwezel::Vector, x1(), y1(), x2(), y2());
-// NOLINTEND
-
-const auto maxRtreeElements = 16;
-const auto minRtreeElements = 4;
+#include <memory>
 
 namespace jwezel {
 
@@ -27,6 +18,20 @@ using std::initializer_list, std::pair;
 struct Surface {
   struct Element;
 
+  ///
+  /// Compositing backend
+  enum class Compositor: u1 {
+    fragments,   //< Split fragments of every element against all elements above it
+    ownershipMap //< Derive fragments from a map of the topmost element per row span
+  };
+
+  ///
+  /// Spatial index of fragments
+  enum class SpatialIndex: u1 {
+    rtree, //< Boost R-tree
+    grid   //< Uniform grid of rows holding fragments ordered by left edge
+  };
+
   struct Fragment {
     explicit Fragment(const Rectangle &area, struct Element *element):
     area(area),
@@ -78,6 +83,17 @@ struct Surface {
     /// @return     The area of the element
     [[nodiscard]] virtual auto area() const -> Rectangle = 0;
 
+    ///
+    /// Get character filling area
+    ///
+    /// Elements whose content is one character throughout return it, which
+    /// spares the text of the area on devices supporting fills.
+    ///
+    /// @param[in]  area  The area, relative to the element
+    ///
+    /// @return     The character, if the area is uniform
+    [[nodiscard]] virtual auto uniform(const Rectangle &/*area*/) const -> optional<Char> {return {};}
+
     virtual void move(const Rectangle &area);
 
     ///
@@ -86,18 +102,61 @@ struct Surface {
     /// @param[in]  area  The area
     virtual auto moveEvent(const Rectangle &/*area*/) -> bool {return false;}
 
-    virtual void update(const vector<Rectangle> &areas);
+    ///
+    /// Update visible parts of areas on the device
+    ///
+    /// Does nothing while the element is completely covered.
+    ///
+    /// @param[in]  areas  The areas, relative to the element
+    virtual void update(const Region &areas);
 
     virtual void update(const Rectangle &area_);
 
-    [[nodiscard]] auto fragments() -> auto & {return fragments_;}
+    ///
+    /// Update area whose content moved inside of it
+    ///
+    /// The device may move what was and stays visible, so that only the rest
+    /// of the area needs an update.
+    ///
+    /// @param[in]  area    The area, relative to the element
+    /// @param[in]  offset  The offset the content moved by
+    void shift(const Rectangle &area, const Vector &offset);
+
+    ///
+    /// Get visible parts of areas
+    ///
+    /// @param[in]  areas  The areas, relative to the element
+    ///
+    /// @return     Fragments of the visible parts
+    [[nodiscard]] auto damage(const Region &areas) -> vector<Fragment>;
+
+    ///
+    /// Get fragments
+    ///
+    /// @return     Visible rectangles of the element
+    [[nodiscard]] auto fragments() const -> vector<Fragment>;
 
-    [[nodiscard]] auto fragments() const -> const auto & {return fragments_;}
+    ///
+    /// Get number of fragments
+    ///
+    /// @return     Number of visible rectangles of the element
+    [[nodiscard]] auto fragmentCount() const {return fragments_.size();}
+
+    ///
+    /// Determine whether any part of the element is visible
+    ///
+    /// Updates of hidden elements are dropped, as their content is taken when
+    /// they are revealed.
+    ///
+    /// @return     True if the element has fragments
+    [[nodiscard]] auto visible() const {return !fragments_.empty();}
 
     [[nodiscard]] auto surface() const -> auto *{return surface_;}
 
     private:
-    vector<Fragment> fragments_;
+    vector<FragmentHandle> fragments_; //< Fragments in the pool of the surface
+    Region dirty_;                     //< Deferred updates, relative to the element
+    size_t zindex_{0};                 //< Position in z-order of the surface
     Surface *surface_{0};
     friend struct Surface;
   };
@@ -110,10 +169,6 @@ struct Surface {
 
   void update(const vector<Fragment> &updates);
 
-  void removeRtreeFragments(Surface::Element &element);
-
-  void insertRtreeFragments(Surface::Element &element);
-
   virtual void addElement(Element *element, Element *below=0);
 
   virtual void deleteElement(Element *element, Element *destination=0);
@@ -132,22 +187,258 @@ struct Surface {
   /// @return     Minimum size
   auto minSize(const Element *exclude=0) const -> Vector;
 
-  [[nodiscard]] auto find(const Vector &position) const -> Fragment *;
+  ///
+  /// Find fragment at position
+  ///
+  /// @param[in]  position  The position
+  ///
+  /// @return     The fragment, which stays valid until fragments change, or 0
+  [[nodiscard]] auto find(const Vector &position) const -> const Fragment *;
 
   [[nodiscard]] auto position(Element *element, int default_=-1) -> int;
 
+  ///
+  /// Determine whether element is on surface
+  ///
+  /// @param[in]  element  The element
+  ///
+  /// @return     True if element is in z-order
+  [[nodiscard]] auto contains(const Element *element) const -> bool;
+
   [[nodiscard]] inline auto zorder() const -> const auto & {return zorder_;}
 
+  ///
+  /// Get number of fragments of all elements
+  ///
+  /// @return     Number of fragments
+  [[nodiscard]] inline auto fragmentCount() const {return index_->size();}
+
+  ///
+  /// Select compositing backend
+  ///
+  /// Rebuilds the fragments of all elements when the backend changes.
+  ///
+  /// @param[in]  compositor  The compositor
+  void compositor(Compositor compositor);
+
+  [[nodiscard]] inline auto compositor() const {return compositor_;}
+
+  ///
+  /// Select spatial index of fragments
+  ///
+  /// @param[in]  index  The index
+  void spatialIndex(SpatialIndex index);
+
+  [[nodiscard]] inline auto spatialIndex() const {return spatialIndex_;}
+
+  ///
+  /// Defer content updates of elements
+  ///
+  /// While deferred, elements collect the areas they update and flush()
+  /// composites all of them at once. Disabling flushes.
+  ///
+  /// @param[in]  defer  Whether to defer updates
+  void deferUpdates(bool defer);
+
+  [[nodiscard]] inline auto deferUpdates() const {return deferUpdates_;}
+
+  ///
+  /// Send deferred content updates of all elements to the device
+  void flush();
+
+  ///
+  /// Start collecting structural changes and updates
+  ///
+  /// Until the outermost transaction is committed, changes only record the
+  /// areas they affect, fragments and find() reflect the last commit and
+  /// device updates are held back. Scrolled and translated content is moved on
+  /// the device by the commit. Transactions nest.
+  void beginTransaction();
+
+  ///
+  /// Commit transaction
+  ///
+  /// The outermost commit recomputes fragments in the affected areas once and
+  /// sends them to the device in a single update.
+  void commit();
+
+  ///
+  /// Determine whether a transaction is open
+  ///
+  /// @return     True if changes are being collected
+  [[nodiscard]] inline auto inTransaction() const {return transactions_ > 0;}
+
+  ///
+  /// Determine whether changes wait for flush or commit
+  ///
+  /// @return     True if there are deferred updates or uncommitted changes
+  [[nodiscard]] inline auto changed() const {
+    return !dirty_.empty() or !damage_.empty() or !moves_.empty() or !restructured_.empty();
+  }
+
+  ///
+  /// Transaction committed at the end of scope
+  struct Transaction {
+    explicit Transaction(Surface &surface);
+
+    ~Transaction();
+
+    Transaction(const Transaction &) = delete;
+
+    Transaction(Transaction &&) = delete;
+
+    auto operator=(const Transaction &) -> Transaction & = delete;
+
+    auto operator=(Transaction &&) -> Transaction & = delete;
+
+    private:
+    Surface &surface_;
+  };
+
   private:
+  ///
+  /// Span of a row owned by the topmost element covering it
+  struct OwnerSpan {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    Dim x1;
+    Dim x2;
+    Element *owner;
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+  };
+
+  using OwnerRow = vector<OwnerSpan>;
+
   void reorder(int source, int destination);
 
   void cover(long pos);
 
-  using RtreeEntry = pair<Rectangle, Fragment *>;
+  ///
+  /// Update cached z-order positions of elements
+  ///
+  /// @param[in]  first  First position
+  /// @param[in]  end    End position
+  void renumber(size_t first, size_t end);
+
+  ///
+  /// Recreate fragments of element inside of areas, keeping those outside
+  ///
+  /// @param[in]  pos    The z-order position of the element
+  /// @param[in]  areas  The areas in which elements above may have changed
+  ///
+  /// @return     New fragments inside of areas
+  auto recover(long pos, const Region &areas) -> vector<Fragment>;
+
+  ///
+  /// Get area of element not covered by elements above
+  ///
+  /// Unlike the fragments, it is current within a transaction.
+  ///
+  /// @param[in]  element  The element
+  ///
+  /// @return     The uncovered area
+  [[nodiscard]] auto uncovered(const Element *element) const -> Region;
+
+  ///
+  /// Get area in which the device shows the current content of element
+  ///
+  /// Within a transaction, the device is current outside of the damage.
+  ///
+  /// @param[in]  element  The element
+  ///
+  /// @return     The area
+  [[nodiscard]] auto onDevice(const Element *element) const -> Region;
+
+  ///
+  /// Move content on the device
+  ///
+  /// Within a transaction the move is recorded and replayed by the commit
+  /// before the updates, so the recording never fails.
+  ///
+  /// @param[in]  destinations  The destination areas
+  /// @param[in]  offset        The offset
+  ///
+  /// @return     True if the device moved the content
+  auto moveOnDevice(const Region &destinations, const Vector &offset) -> bool;
+
+  ///
+  /// Get updates of moved element
+  ///
+  /// When the element was translated, the device may move content that was
+  /// and stays visible, which then needs no update. Translations must not
+  /// change the content of the element.
+  ///
+  /// @param[in]  element          The element
+  /// @param[in]  previousArea     The area before the move
+  /// @param[in]  previousVisible  The visible part before the move
+  ///
+  /// @return     Fragments needing an update
+  auto moved(Element *element, const Rectangle &previousArea, const Region &previousVisible) -> vector<Fragment>;
+
+  ///
+  /// Replace fragments of element
+  ///
+  /// Fragments with unchanged area keep their pool slot and index entry.
+  ///
+  /// @param      element    The element
+  /// @param[in]  fragments  The new fragments
+  void assignFragments(Element &element, const vector<Fragment> &fragments);
+
+  ///
+  /// Add ownership map rows so that the last row stands for rows below area
+  ///
+  /// @param[in]  area  The area
+  void extendOwners(const Rectangle &area);
+
+  ///
+  /// Recompute ownership map rows intersecting area and the fragments of all
+  /// elements whose ownership changed
+  ///
+  /// @param[in]  area  The area whose ownership may have changed
+  ///
+  /// @return     Fragments whose owner changed
+  auto recompose(const Rectangle &area) -> vector<Fragment>;
+
+  ///
+  /// Get fragments of element from ownership map
+  ///
+  /// @param[in]  element  The element
+  ///
+  /// @return     Fragments
+  [[nodiscard]] auto ownedFragments(Element *element) const -> vector<Fragment>;
+
+  ///
+  /// Get ownership map row indexes covering rows of area
+  ///
+  /// The last row stands for all rows from its index on.
+  ///
+  /// @param[in]  area  The area
+  ///
+  /// @return     First and end row index
+  [[nodiscard]] auto ownerRows(const Rectangle &area) const -> pair<size_t, size_t>;
+
+  ///
+  /// Paint span of ownership map row
+  ///
+  /// @param      row    The row
+  /// @param[in]  x1     Start of span
+  /// @param[in]  x2     End of span
+  /// @param[in]  owner  The owner of the span
+  static void paint(OwnerRow &row, Dim x1, Dim x2, Element *owner);
 
   vector<Element *> zorder_;
   Device *device_{};
-  boost::geometry::index::rtree<RtreeEntry, boost::geometry::index::quadratic<maxRtreeElements, minRtreeElements>> rtree;
+  Compositor compositor_{Compositor::fragments};
+  vector<OwnerRow> owners_{OwnerRow{OwnerSpan{0, DimHigh, 0}}}; //< Ownership map rows, last row repeats to the bottom
+  vector<Fragment> fragmentPool_;        //< Fragments of all elements, indexed by handle
+  vector<FragmentHandle> freeFragments_; //< Unused slots of the fragment pool
+  SpatialIndex spatialIndex_{SpatialIndex::rtree};
+  std::unique_ptr<FragmentIndex> index_{std::make_unique<RtreeIndex>()};
+  bool deferUpdates_{false}; //< Whether elements collect updates until flush
+  vector<Element *> dirty_;  //< Elements with deferred updates
+  int transactions_{0};      //< Depth of open transactions
+  Region damage_;            //< Area affected by changes of open transactions
+  vector<pair<Region, Vector>> moves_; //< Device moves of open transactions by destination and offset
+  Region restructured_;      //< Area where open transactions added, deleted, reshaped or restacked elements
 };
 
 struct TextElement: Surface::Element {
@@ -216,6 +507,15 @@ struct TextElement: Surface::Element {
   /// @return     vector of rectangles
   auto box(const Box &box = Box{}) -> TextElement &;
 
+  ///
+  /// Scroll area vertically
+  ///
+  /// @param[in]  area   The area
+  /// @param[in]  lines  Number of lines to scroll up, down if negative
+  ///
+  /// @return     this
+  auto scroll(const Rectangle &area=RectangleMax, Dim lines=1) -> TextElement &;
+
   auto moveEvent(const Rectangle &/*area*/) -> bool override;
 
   auto above(TextElement *element=0) -> bool;
@@ -252,4 +552,69 @@ struct TextElement: Surface::Element {
   Text text_;
 };
 
+///
+/// Element whose content is generated on demand
+///
+/// Only the areas the surface requests are rendered, so the element needs no
+/// buffer of its size.
+struct ProceduralElement: Surface::Element {
+  ///
+  /// Content generator
+  ///
+  /// Gets an area relative to the element, which lies inside of it, and
+  /// returns its text.
+  using Renderer = std::function<Text(const Rectangle &area)>;
+
+  ///
+  /// Constructor
+  ///
+  /// @param[in]  surface   The surface
+  /// @param[in]  area      The area
+  /// @param[in]  renderer  The content generator
+  /// @param[in]  below     The element to insert below
+  explicit ProceduralElement(Surface *surface, const Rectangle &area, Renderer renderer, Surface::Element *below=0);
+
+  ProceduralElement() = default;
+
+  ProceduralElement(const ProceduralElement &) = default;
+
+  ProceduralElement(ProceduralElement &&) = default;
+
+  auto operator=(const ProceduralElement &) -> ProceduralElement & = default;
+
+  auto operator=(ProceduralElement &&) -> ProceduralElement & = default;
+
+  ///
+  /// Destroy ProceduralElement
+  ~ProceduralElement() override;
+
+  ///
+  /// Replace content generator
+  ///
+  /// @param[in]  renderer  The renderer
+  void renderer(Renderer renderer);
+
+  ///
+  /// Update area whose generated content changed
+  ///
+  /// @param[in]  area  The area, relative to the element
+  void invalidate(const Rectangle &area=RectangleMax);
+
+  auto moveEvent(const Rectangle &area) -> bool override;
+
+  [[nodiscard]] auto area() const -> Rectangle override {return area_;}
+
+  ///
+  /// Render area
+  ///
+  /// @param[in]  area  The area, clipped to the element
+  ///
+  /// @return     text
+  [[nodiscard]] auto text(const Rectangle &area = RectangleMax) const -> Text override;
+
+  private:
+  Rectangle area_;
+  Renderer renderer_;
+};
+
 } //namespace jwezel
@@ -7,10 +7,21 @@
 #include "text.hh"
 #include "window.hh"
 
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <format>
+#include <iostream>
+#include <poll.h>
+#include <system_error>
 #include <unistd.h>
 
 namespace jwezel {
 
+using namespace std::chrono_literals;
+using std::array, std::format, std::system_category, std::system_error;
+using std::chrono::steady_clock;
+
 Terminal::Terminal(
   const Char &background,
   const Vector &initialPosition,
@@ -33,6 +44,19 @@ minimumSize_{display_.size()},
 running_{false}
 {}
 
+Terminal::~Terminal() {
+  try {
+    if (frameRate_) {
+      // Render changes collected for the next frame
+      flush();
+      frameRate(0);
+    }
+    inputThread(false);
+  } catch (std::exception &error) {
+    std::cerr << "Error: " << error.what() << "\n";
+  }
+}
+
 void Terminal::addElement(Surface::Element *element, Surface::Element * below) {
   if (element != &backdrop_) {
     expand(element->area().position2());
@@ -46,6 +70,7 @@ void Terminal::deleteElement(Element *element, Element *destination) {
 }
 
 void Terminal::moveWindow(Window &window, const Rectangle &area) {
+  const Transaction transaction{*this};
   expand(Vector{area.x2(), area.y2()});
   reshapeElement(&window, area);
   contract();
@@ -56,14 +81,33 @@ void Terminal::focus(Window *window) {
 }
 
 auto Terminal::event() -> Event {
-  return keyboard_.event();
+  if (!inputThread_.joinable()) {
+    auto result{keyboard_.event()};
+    result.time(steady_clock::now());
+    return result;
+  }
+  inputQueue_.wait();
+  auto result{std::move(*inputQueue_.pop())};
+  if (!result()) {
+    // Input thread failed
+    auto error{inputError_};
+    inputThread(false);
+    std::rethrow_exception(error);
+  }
+  return result;
 }
 
 void Terminal::runEvent() {
-  auto currentEvent{keyboard_.event()};
+  if (const auto deadline{nextFrame()}; deadline and !waitInput(deadline.value())) {
+    frame();
+    return;
+  }
+  auto currentEvent{event()};
   if (focusWindow_) {
     focusWindow_->event(currentEvent);
   }
+  flush();
+  frame();
 }
 
 void Terminal::run() {
@@ -80,6 +124,143 @@ void Terminal::stop() {
   running_ = false;
 }
 
+void Terminal::frameRate(unsigned fps) {
+  if (fps == frameRate_) {
+    return;
+  }
+  if (frameRate_) {
+    commit();
+  }
+  frameRate_ = fps;
+  if (fps) {
+    frameInterval_ = steady_clock::duration{1s} / fps;
+    lastFrame_ = {};
+    beginTransaction();
+  }
+}
+
+auto Terminal::frame() -> bool {
+  if (!frameRate_ or !changed()) {
+    return false;
+  }
+  const auto now{steady_clock::now()};
+  if (now < lastFrame_ + frameInterval_) {
+    return false;
+  }
+  flush();
+  commit();
+  beginTransaction();
+  lastFrame_ = now;
+  return true;
+}
+
+auto Terminal::nextFrame() const -> optional<steady_clock::time_point> {
+  if (!frameRate_ or !changed()) {
+    return nullopt;
+  }
+  return lastFrame_ + frameInterval_;
+}
+
+auto Terminal::waitInput(steady_clock::time_point deadline) -> bool {
+  while (true) {
+    const auto threaded{inputThread_.joinable()};
+    if (threaded) {
+      // Notifications are taken before checking the queue, so none of a later event is lost
+      array<char, InputQueueSize> notifications{};
+      while (::read(inputReady_[0], notifications.data(), notifications.size()) > 0) {}
+    }
+    if (threaded? inputQueue_.size() != 0: keyboard_.pending()) {
+      return true;
+    }
+    const auto now{steady_clock::now()};
+    if (threaded and now >= deadline) {
+      return false;
+    }
+    const auto timeout{now < deadline? std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count(): 0};
+    pollfd fd{threaded? inputReady_[0]: keyboard_.fd(), POLLIN, 0};
+    const auto ready{::poll(&fd, 1, int(timeout))};
+    if (ready < 0 and errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      throw system_error(errno, system_category(), format("Could not poll keyboard {}", fd.fd));
+    }
+    if (!threaded) {
+      return ready > 0;
+    }
+  }
+}
+
+void Terminal::inputThread(bool enable) {
+  if (enable == inputThread_.joinable()) {
+    return;
+  }
+  if (enable) {
+    if (::pipe(inputStop_.data()) != 0) {
+      throw system_error(errno, system_category(), "Could not create input thread pipe");
+    }
+    if (::pipe(inputReady_.data()) != 0) {
+      const auto error{errno};
+      for (auto &fd: inputStop_) {
+        (void)::close(fd);
+        fd = -1;
+      }
+      throw system_error(error, system_category(), "Could not create input thread pipe");
+    }
+    for (const auto fd: inputReady_) {
+      (void)::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    }
+    inputStopping_ = false;
+    inputError_ = nullptr;
+    keyboard_.interrupt(inputStop_[0]);
+    inputThread_ = std::thread{&Terminal::readInput, this};
+  } else {
+    inputStopping_ = true;
+    (void)::write(inputStop_[1], "", 1);
+    // Events not yet taken are dropped, which also wakes a reader waiting on a full queue
+    while (inputQueue_.pop()) {}
+    inputThread_.join();
+    keyboard_.interrupt(-1);
+    for (auto *pipe: {&inputStop_, &inputReady_}) {
+      for (auto &fd: *pipe) {
+        (void)::close(fd);
+        fd = -1;
+      }
+    }
+    while (inputQueue_.pop()) {}
+  }
+}
+
+void Terminal::readInput() {
+  try {
+    // Reads are interrupted by the stop pipe, also within a sequence
+    while (!inputStopping_) {
+      if (!queueInput(keyboard_.event())) {
+        break;
+      }
+    }
+  } catch (Keyboard::Interrupted &) {
+    // Stopped
+  } catch (...) {
+    // Hand the error over to the consumer with an empty event
+    inputError_ = std::current_exception();
+    queueInput(Event{});
+  }
+}
+
+auto Terminal::queueInput(Event &&event) -> bool {
+  event.time(steady_clock::now());
+  while (!inputQueue_.push(std::move(event))) {
+    if (inputStopping_) {
+      return false;
+    }
+    inputQueue_.waitSpace();
+  }
+  // Wake waitInput, a full pipe already does
+  (void)::write(inputReady_[1], "", 1);
+  return true;
+}
+
 auto Terminal::expand(const Vector &size) -> bool {
   if (!expand_) {
     return false;
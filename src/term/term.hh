@@ -3,12 +3,18 @@
 #include "display.hh"
 #include "geometry.hh"
 #include "keyboard.hh"
+#include "spsc_ring.hh"
 #include "surface.hh"
 #include "term_interface.hh"
 #include "text.hh"
 #include "window.hh"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <optional>
+#include <thread>
 
 
 namespace jwezel {
@@ -46,6 +52,18 @@ struct Terminal: Surface, TerminalInterface {
     bool contract=true
   );
 
+  ///
+  /// Destructor
+  ~Terminal() override;
+
+  Terminal(const Terminal &) = delete;
+
+  Terminal(Terminal &&) = delete;
+
+  auto operator=(const Terminal &) -> Terminal & = delete;
+
+  auto operator=(Terminal &&) -> Terminal & = delete;
+
   void addElement(Surface::Element *element, Surface::Element * below) override;
 
   void deleteElement(Element *element, Element *destination) override;
@@ -70,17 +88,59 @@ struct Terminal: Surface, TerminalInterface {
   ///
   /// Get event
   ///
+  /// The event is stamped with the time it was read, with the input thread
+  /// the time it was queued.
+  ///
   /// @return     Event
   [[nodiscard]] auto event() -> Event;
 
+  ///
+  /// Dispatch next event to the focus window, then flush deferred updates
   void runEvent();
 
   ///
   /// Run loop
   void run();
 
+  ///
+  /// Limit output to a maximum frame rate
+  ///
+  /// With a limit, all changes are collected in a transaction that is
+  /// committed at most once per frame, so only the latest state is composited
+  /// and written. No frames are scheduled while nothing changes.
+  ///
+  /// @param[in]  fps   Maximum frames per second, 0 for no limit
+  void frameRate(unsigned fps);
+
+  [[nodiscard]] auto frameRate() const -> unsigned {return frameRate_;}
+
+  ///
+  /// Render frame if changes are due
+  ///
+  /// @return     True if a frame was rendered
+  auto frame() -> bool;
+
+  ///
+  /// Get time of next frame
+  ///
+  /// @return     Time at which collected changes are due, none while idle
+  [[nodiscard]] auto nextFrame() const -> optional<std::chrono::steady_clock::time_point>;
+
   void stop();
 
+  ///
+  /// Start or stop the input thread
+  ///
+  /// While running, a dedicated thread reads and decodes keyboard input and
+  /// event() takes the events from a queue, so rendering does not delay input
+  /// and escape sequence timing is not distorted by render time. Display queries
+  /// reading terminal replies (e.g. Display::cursor) must not be made meanwhile.
+  ///
+  /// @param[in]  enable  Whether to run the input thread
+  void inputThread(bool enable);
+
+  [[nodiscard]] auto inputThread() const -> bool {return inputThread_.joinable();}
+
   [[nodiscard]] auto display() -> Display & {return display_;}
 
   [[nodiscard]] auto desktop() -> Window & {return desktop_;}
@@ -102,6 +162,28 @@ struct Terminal: Surface, TerminalInterface {
   auto contract() -> bool override;
 
   private:
+  static constexpr size_t InputQueueSize{256};
+
+  ///
+  /// Read events into input queue until stopped (input thread)
+  void readInput();
+
+  ///
+  /// Append event to input queue, waiting while it is full
+  ///
+  /// @param      event  The event
+  ///
+  /// @return     False if the input thread was stopped meanwhile
+  auto queueInput(Event &&event) -> bool;
+
+  ///
+  /// Wait for input
+  ///
+  /// @param[in]  deadline  Time until which to wait
+  ///
+  /// @return     True if input is available
+  auto waitInput(std::chrono::steady_clock::time_point deadline) -> bool;
+
   bool expand_;
   bool contract_;
   Keyboard keyboard_;
@@ -111,6 +193,15 @@ struct Terminal: Surface, TerminalInterface {
   Window *focusWindow_;
   Vector minimumSize_;
   bool running_;
+  SpscRing<Event, InputQueueSize> inputQueue_;
+  std::thread inputThread_;
+  std::array<int, 2> inputStop_{-1, -1};
+  std::array<int, 2> inputReady_{-1, -1};
+  std::atomic<bool> inputStopping_{false};
+  std::exception_ptr inputError_;
+  unsigned frameRate_{0};
+  std::chrono::steady_clock::duration frameInterval_{};
+  std::chrono::steady_clock::time_point lastFrame_{};
 };
 
 } // namespace jwezel
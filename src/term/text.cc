@@ -680,7 +680,55 @@ auto initializedQuad2Box() -> unordered_map<QuadValue, Unicode> {
   }
   return result;
 }
-}  // namespace
+
+///
+/// Bounding rectangle of changed cells
+struct ChangedBounds {
+  ///
+  /// Record changed cell
+  ///
+  /// @param[in]  column  The column
+  /// @param[in]  line    The line
+  void add(Dim column, Dim line) {
+    x1_ = min(x1_, column);
+    y1_ = min(y1_, line);
+    x2_ = max(x2_, toDim(column + 1));
+    y2_ = max(y2_, toDim(line + 1));
+  }
+
+  ///
+  /// Replace cell, recording it if it changes
+  ///
+  /// @param      cell    The cell
+  /// @param[in]  value   The new value
+  /// @param[in]  column  The column
+  /// @param[in]  line    The line
+  void set(Char &cell, const Char &value, Dim column, Dim line) {
+    if (cell != value) {
+      cell = value;
+      add(column, line);
+    }
+  }
+
+  ///
+  /// Get bounds
+  ///
+  /// @return     Bounds of the changed cells, if any
+  [[nodiscard]] auto bounds() const -> optional<Rectangle> {
+    if (x1_ >= x2_) {
+      return {};
+    }
+    return Rectangle{x1_, y1_, x2_, y2_};
+  }
+
+  private:
+  Dim x1_{DimHigh};
+  Dim y1_{DimHigh};
+  Dim x2_{DimLow};
+  Dim y2_{DimLow};
+};
+
+} // namespace
 
 void Char::drawLineChar(const Segments &segments, u1 dash, bool roundedCorners) {
   static const unordered_map<Unicode, QuadTuple> box2Quad{initializedBox2Quad()};
@@ -731,22 +779,29 @@ void Text::extend(const Vector &size, const Char &fill) {
   }
 }
 
-auto Text::fill(const Char &fill, const Rectangle &area) -> Rectangle {
+auto Text::fill(const Char &fill, const Rectangle &area) -> optional<Rectangle> {
+  // Cells added by extending count as changed
+  const auto previous{size()};
   auto area_{area == RectangleMax? Rectangle{Vector{0, 0}, size()}: (extend(Vector{area.x2(), area.y2()}, fill), area)};
-  const auto _line{String(area_.width(), fill)};
+  ChangedBounds changed;
   for (auto l = area_.y1(); l < area_.y2(); ++l) {
-    std::copy(_line.begin(), _line.end(), data[l].begin() + area_.x1());
+    for (auto c = area_.x1(); c < area_.x2(); ++c) {
+      if (l >= previous.y() or c >= previous.x() or data[l][c] != fill) {
+        data[l][c] = fill;
+        changed.add(c, l);
+      }
+    }
   }
-  return area_;
+  return changed.bounds();
 }
 
-void Text::patch(
+auto Text::patch(
   const Text &other,
   const Vector &position,
   const AttributeMode &mixDefaultMode,
   const AttributeMode &overrideMixMode,
   const AttributeMode &resetMixMode
-) {
+) -> optional<Rectangle> {
   assert(data.data() != other.data.data()); // NOLINT
   const Dim
     xdest = std::max(toDim(0), position.x()),
@@ -755,25 +810,28 @@ void Text::patch(
     ybegin = toDim(ydest - position.y()),
     width_ = toDim(std::min(width() - xdest, other.width() - xbegin)),
     height_ = toDim(std::min(height() - ydest, other.height() - ybegin));
+  ChangedBounds changed;
   for (Dim l = 0; l < height_; ++l) {
     const Dim owidth = std::min(toDim(other.data[ybegin + l].size()), width_);
     if (xdest + owidth > 0) {
-      auto dest = data[ydest + l].begin() + xdest;
-      auto source = other.data[ybegin + l].begin();
-      while (dest != data[ydest + l].begin() + xdest + owidth) {
-        *dest++ = dest->combine(*source++, mixDefaultMode, overrideMixMode, resetMixMode);
+      auto &line{data[ydest + l]};
+      const auto &source{other.data[ybegin + l]};
+      for (Dim c = 0; c < owidth; ++c) {
+        auto &cell{line[xdest + c]};
+        changed.set(cell, cell.combine(source[c], mixDefaultMode, overrideMixMode, resetMixMode), toDim(xdest + c), toDim(ydest + l));
       }
     }
   }
+  return changed.bounds();
 }
 
-void Text::patchArea(
+auto Text::patchArea(
   const Text          &other,
   const Rectangle     &area,
   const AttributeMode &mixDefault,
   const AttributeMode &overrideMix,
   const AttributeMode &resetMix
-) {
+) -> optional<Rectangle> {
   if (data.data() == other.data.data()) {
     throw range_error("This and other are the same");
   }
@@ -782,18 +840,56 @@ void Text::patchArea(
   if ((area_ & Rectangle{0, 0, this->width(), this->height()}) != area_) {
     throw runtime_error("area must be within text");
   }
+  ChangedBounds changed;
   auto data_ = other.data.begin();
   for (Dim l = 0; l < area_.height(); ++l) {
-    auto source = data_->begin();
-    const auto sourceEnd = data_->end();
-    auto
-      dest = data[area_.y1() + l].begin() + area_.x1(),
-      _limit = data[area_.y1() + l].begin() + area_.x2();
-    while (dest != _limit && source != sourceEnd) {
-      *dest++ = dest->combine(*source++, mixDefault, overrideMix, resetMix);
+    auto &line{data[area_.y1() + l]};
+    const auto columns{std::min(toDim(data_->size()), area_.width())};
+    for (Dim c = 0; c < columns; ++c) {
+      auto &cell{line[area_.x1() + c]};
+      changed.set(cell, cell.combine((*data_)[c], mixDefault, overrideMix, resetMix), toDim(area_.x1() + c), toDim(area_.y1() + l));
     }
     ++data_;
   }
+  return changed.bounds();
+}
+
+auto Text::scroll(const Rectangle &area, Dim lines, const Char &fill) -> optional<Rectangle> {
+  const auto limits{Rectangle{0, 0, width(), height()}};
+  const auto area_{area.defaultTo(limits) & limits};
+  if (!area_ or lines == 0) {
+    return {};
+  }
+  const auto x1{area_->x1()}, y1{area_->y1()}, x2{area_->x2()}, y2{area_->y2()};
+  const auto count{std::min(Dim(std::abs(lines)), area_->height())};
+  if (x1 == 0 and x2 == width()) {
+    const auto rows{data.begin() + y1}, rowsEnd{data.begin() + y2};
+    if (lines > 0) {
+      std::rotate(rows, rows + count, rowsEnd);
+    } else {
+      std::rotate(rows, rowsEnd - count, rowsEnd);
+    }
+  } else {
+    // Lines may be shorter than the area
+    const auto columns{[x1, x2](const String &line) {return std::max(0, std::min(int(x2), int(line.size())) - x1);}};
+    const auto copy{[&columns, x1](const String &source, String &destination) {
+      std::copy_n(source.begin() + x1, std::min(columns(source), columns(destination)), destination.begin() + x1);
+    }};
+    if (lines > 0) {
+      for (auto row = int(y1); row + count < y2; ++row) {
+        copy(data[row + count], data[row]);
+      }
+    } else {
+      for (auto row = int(y2) - 1; row >= y1 + count; --row) {
+        copy(data[row - count], data[row]);
+      }
+    }
+  }
+  const auto vacated{lines > 0? pair{Dim(y2 - count), y2}: pair{y1, Dim(y1 + count)}};
+  for (auto l = vacated.first; l < vacated.second; ++l) {
+    std::fill_n(data[l].begin() + x1, std::max(0, std::min(int(x2), int(data[l].size())) - x1), fill);
+  }
+  return area_;
 }
 
 void Text::resize(const Vector &size, const Char &fill) {
@@ -808,17 +904,19 @@ void Text::resize(const Vector &size, const Char &fill) {
   extend(size, fill);
 }
 
-void Text::setAttr(const CharAttributes &attr, const Rectangle &area, const AttributeMode &setMix) {
+auto Text::setAttr(const CharAttributes &attr, const Rectangle &area, const AttributeMode &setMix) -> optional<Rectangle> {
   const auto limits = Rectangle{0, 0, width(), height()};
   const std::optional<Rectangle> area_ = area.defaultTo(limits) & limits;
+  ChangedBounds changed;
   if (area_) {
     const Rectangle _area = area_.value();
     for (Dim l = _area.y1(); l < _area.y2(); ++l) {
       for (Dim c = _area.x1(); c < _area.x2(); ++c) {
-        data[l][c] = data[l][c].combine(Char(NoneRune, attr), AttributeMode::default_, AttributeMode::ignore, setMix);
+        changed.set(data[l][c], data[l][c].combine(Char(NoneRune, attr), AttributeMode::default_, AttributeMode::ignore, setMix), c, l);
       }
     }
   }
+  return changed.bounds();
 }
 
 auto Text::operator [](const Rectangle &area) const -> Text {
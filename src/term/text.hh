@@ -492,8 +492,13 @@ struct Text {
   ///
   /// Fill text with character
   ///
+  /// Text is extended to contain area.
+  ///
   /// @param[in]  fill  Fill character
-  auto fill(const Char &fill=Space, const Rectangle &area=RectangleMax) -> Rectangle;
+  /// @param[in]  area  The area
+  ///
+  /// @return     Bounds of the changed cells, if any
+  auto fill(const Char &fill=Space, const Rectangle &area=RectangleMax) -> optional<Rectangle>;
 
   ///
   /// Put one text rectangle into another at a specific position
@@ -503,13 +508,15 @@ struct Text {
   /// @param[in]  mixDefaultMode   The mix default mode
   /// @param[in]  overrideMixMode  The override mix mode
   /// @param[in]  resetMixMode     The reset mix mode
-  void patch(
+  ///
+  /// @return     Bounds of the changed cells, if any
+  auto patch(
     const Text &other,
     const Vector &position=Vector{0, 0},
     const AttributeMode &mixDefaultMode=AttributeMode::replace,
     const AttributeMode &overrideMixMode=AttributeMode::default_,
     const AttributeMode &resetMixMode=AttributeMode::default_
-  );
+  ) -> optional<Rectangle>;
 
   ///
   /// Put text into sub-rectangle
@@ -519,13 +526,15 @@ struct Text {
   /// @param[in]  mixDefault   The mix default
   /// @param[in]  overrideMix  The override mix
   /// @param[in]  resetMix     The reset mix
-  void patchArea(
+  ///
+  /// @return     Bounds of the changed cells, if any
+  auto patchArea(
     const Text &other,
     const Rectangle &area=RectangleMax,
     const AttributeMode &mixDefault=AttributeMode::replace,
     const AttributeMode &overrideMix=AttributeMode::default_,
     const AttributeMode &resetMix=AttributeMode::default_
-  );
+  ) -> optional<Rectangle>;
 
   ///
   /// Resize text
@@ -533,13 +542,32 @@ struct Text {
   /// @param[in]  size  The size
   void resize(const Vector &size, const Char &fill);
 
+  ///
+  /// Scroll area vertically
+  ///
+  /// Areas spanning the full width rotate their lines, which moves no
+  /// characters.
+  ///
+  /// @param[in]  area   The area
+  /// @param[in]  lines  Number of lines to scroll up, down if negative
+  /// @param[in]  fill   Fill character of lines scrolled in
+  ///
+  /// @return     The scrolled area, if any
+  auto scroll(const Rectangle &area, Dim lines, const Char &fill=Space) -> optional<Rectangle>;
+
   ///
   /// Set Char attributes.
   ///
   /// @param[in]  attr    The attribute
   /// @param[in]  area    The area
   /// @param[in]  setMix  The set mix
-  void setAttr(const CharAttributes &attr, const Rectangle &area=RectangleMax, const AttributeMode &setMix=AttributeMode::default_);
+  ///
+  /// @return     Bounds of the changed cells, if any
+  auto setAttr(
+    const CharAttributes &attr,
+    const Rectangle &area=RectangleMax,
+    const AttributeMode &setMix=AttributeMode::default_
+  ) -> optional<Rectangle>;
 
   ///
   /// Get sub-rectangle.
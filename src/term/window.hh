@@ -41,6 +41,12 @@ struct Backdrop: public Surface::Element {
   /// @return     text
   [[nodiscard]] auto text(const Rectangle &area=RectangleMax) const -> Text override;
 
+  ///
+  /// Get character filling area
+  ///
+  /// @return     Space
+  [[nodiscard]] auto uniform(const Rectangle &/*area*/) const -> optional<Char> override {return Space;}
+
   ///
   /// Move window
   ///
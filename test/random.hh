@@ -0,0 +1,14 @@
+#pragma once
+
+// Reproducible pseudo-random numbers
+struct Random {
+  explicit Random(unsigned seed): seed_{seed} {}
+
+  // Get number from 0 to limit - 1
+  auto operator()(int limit) -> int {
+    seed_ = seed_ * 1103515245U + 12345U;
+    return int((seed_ >> 16U) % unsigned(limit));
+  }
+
+  unsigned seed_;
+};
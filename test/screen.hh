@@ -0,0 +1,61 @@
+#pragma once
+
+#include <term/device.hh>
+#include <term/geometry.hh>
+#include <term/surface.hh>
+#include <term/text.hh>
+#include <term/update.hh>
+
+#include <ranges>
+#include <vector>
+
+// Device keeping a screen image
+struct Screen: jwezel::Device {
+  explicit Screen(const jwezel::Vector &size): text_{jwezel::Char(' '), size} {}
+  [[nodiscard]] auto area() const -> jwezel::Rectangle override {
+    return jwezel::Rectangle{jwezel::Vector{0, 0}, text_.size()};
+  }
+  void update(const jwezel::Updates &updates) override {
+    for (const auto &update: updates) {
+      text_.patch(update.text, update.position);
+    }
+    ++calls_;
+  }
+  jwezel::Text text_;
+  size_t calls_{0};
+};
+
+// Screen moving its own content
+struct ShiftingScreen: Screen {
+  using Screen::Screen;
+  auto move(const std::vector<jwezel::Rectangle> &areas, const jwezel::Vector &offset) -> bool override {
+    const jwezel::Rectangle screen{jwezel::Vector{0, 0}, text_.size()};
+    for (const auto &area: areas) {
+      if ((area & screen) != area or (area + offset & screen) != area + offset) {
+        return false;
+      }
+    }
+    jwezel::Updates updates;
+    for (const auto &area: areas) {
+      updates.emplace_back(area.position() + offset, text_[area]);
+      moved_ += area.width() * area.height();
+    }
+    update(updates);
+    ++moves_;
+    return true;
+  }
+  int moved_{0};
+  int moves_{0};
+};
+
+// Screen image expected from the elements above the backdrop of a surface
+inline auto ExpectedScreen(const jwezel::Surface &surface, const jwezel::Vector &size) -> jwezel::Text {
+  jwezel::Text result{jwezel::Char(' '), size};
+  for (const auto *element: surface.zorder() | std::views::drop(1)) {
+    const auto visible{element->area() & jwezel::Rectangle{jwezel::Vector{0, 0}, size}};
+    if (visible) {
+      result.patch(element->text(visible.value() - element->area().position()), visible->position());
+    }
+  }
+  return result;
+}
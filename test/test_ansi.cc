@@ -0,0 +1,136 @@
+#include <term/ansi.hh>
+#include <term/text.hh>
+
+#include <doctest/doctest.h>
+#include <string>
+#include <string_view>
+
+using
+  jwezel::AnsiParser,
+  jwezel::Char,
+  jwezel::CharAttributes,
+  jwezel::Rgb,
+  jwezel::RgbBlack,
+  jwezel::RgbGray5,
+  jwezel::RgbNone,
+  jwezel::Text,
+  jwezel::bold,
+  jwezel::underline;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+// NOLINTBEGIN(readability-magic-numbers)
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+namespace {
+
+auto parse(std::string_view input) -> Text {
+  AnsiParser parser;
+  return parser.parse(input).take();
+}
+
+} // namespace
+
+TEST_CASE("ANSI parser") {
+  SUBCASE("Plain") {
+    const auto text{parse("one\ntwo and a longer line\n")};
+    REQUIRE_EQ(text.data.size(), 2);
+    CHECK_EQ(jwezel::asString(text.data[0]), "one");
+    CHECK_EQ(jwezel::asString(text.data[1]), "two and a longer line");
+    CHECK_EQ(parse("äöü\n"), Text("äöü"));
+    AnsiParser parser;
+    parser.parse("no end");
+    CHECK(parser.take().data.empty());
+    CHECK_EQ(Text(jwezel::asString(parser.line())), Text("no end"));
+  }
+  SUBCASE("Colours") {
+    const auto text{parse("a\x1b[31mb\x1b[1;44mc\x1b[39md\x1b[0me\x1b[38;5;196mf\x1b[48;2;0;0;0mg\x1b[mh\n")};
+    REQUIRE_EQ(text.data.size(), 1);
+    const auto &line{text.data[0]};
+    REQUIRE_EQ(line.size(), 8);
+    const Rgb red{205.0F / 255, 0, 0}, blue{0, 0, 238.0F / 255}, paletteRed{1, 0, 0};
+    CHECK_EQ(line[0], Char('a'));
+    CHECK_EQ(line[1], Char('b', red));
+    CHECK_EQ(line[2], Char('c', red, blue, bold));
+    CHECK_EQ(line[3], Char('d', RgbNone, blue, bold));
+    CHECK_EQ(line[4], Char('e'));
+    CHECK_EQ(line[5], Char('f', paletteRed));
+    CHECK_EQ(line[6], Char('g', paletteRed, RgbBlack));
+    CHECK_EQ(line[7], Char('h'));
+  }
+  SUBCASE("Sub-parameters") {
+    const auto text{parse("\x1b[38:2::10:20:30ma\x1b[48:2:0:0:238;1mb\x1b[38:5:196;4:3mc\x1b[0;4:0;31md\n")};
+    REQUIRE_EQ(text.data.size(), 1);
+    const auto &line{text.data[0]};
+    REQUIRE_EQ(line.size(), 4);
+    const Rgb rgb{10.0F / 255, 20.0F / 255, 30.0F / 255}, blue{0, 0, 238.0F / 255}, red{205.0F / 255, 0, 0}, paletteRed{1, 0, 0};
+    CHECK_EQ(line[0], Char('a', rgb));
+    CHECK_EQ(line[1], Char('b', rgb, blue, bold));
+    CHECK_EQ(line[2], Char('c', paletteRed, blue, bold | underline));
+    // Sub-parameters of other parameters are skipped
+    CHECK_EQ(line[3], Char('d', red, RgbNone, underline));
+  }
+  SUBCASE("Attributes") {
+    const auto text{parse("\x1b[1;4ma\x1b[22mb\x1b[24mc\n")};
+    CHECK_EQ(text.data[0][0].attributes.attr, bold | underline);
+    CHECK_EQ(text.data[0][1].attributes.attr, underline);
+    CHECK_EQ(text.data[0][2].attributes.attr, 0);
+  }
+  SUBCASE("Defaults") {
+    const CharAttributes defaults{RgbGray5};
+    AnsiParser parser{defaults};
+    const auto text{parser.parse("a\x1b[31mb\x1b[0mc\n").take()};
+    CHECK(text.data[0][0].attributes == defaults);
+    CHECK(text.data[0][2].attributes == defaults);
+  }
+  SUBCASE("Line editing") {
+    CHECK_EQ(parse("abc\rx\n"), Text("xbc"));
+    CHECK_EQ(parse("progress 10%\rprogress 100%\r\n"), Text("progress 100%"));
+    CHECK_EQ(parse("abc\bd\n"), Text("abd"));
+    CHECK_EQ(parse("a\tb\n"), Text("a       b"));
+    CHECK_EQ(parse("abcdef\r\x1b[Kxy\n"), Text("xy"));
+    CHECK_EQ(parse("abcdef\rab\x1b[0K\n"), Text("ab"));
+    CHECK_EQ(parse("abcdef\rab\x1b[1Kz\n"), Text("  zdef"));
+  }
+  SUBCASE("Other sequences") {
+    CHECK_EQ(parse("\x1b]8;;file:///x\x1b\\link\x1b]8;;\x1b\\ \x1b]0;title\aok\n"), Text("link ok"));
+    CHECK_EQ(parse("\x1b[?25la\x1b[2Jb\x1b(Bc\x1b" "7d\n"), Text("abcd"));
+    CHECK_EQ(parse("a\x01\x7f" "b\n"), Text("ab"));
+    // Control characters and ESC cut a sequence short
+    CHECK_EQ(parse("a\x1b\nb\n"), Text("a\nb"));
+    CHECK_EQ(parse("abc\x1b\rd\n"), Text("dbc"));
+    const auto text{parse("a\x1b\x1b[31mb\n")};
+    CHECK_EQ(text.data[0][1], Char('b', Rgb{205.0F / 255, 0, 0}));
+  }
+  SUBCASE("Invalid UTF-8") {
+    CHECK_EQ(parse("a\xff" "b\xc3" "c\xe2\x82\n"), Text("a\xef\xbf\xbd" "b\xef\xbf\xbd" "c\xef\xbf\xbd"));
+  }
+}
+
+TEST_CASE("ANSI parser chunks") {
+  const std::string input{
+    "plain text line\n\x1b[1;38;2;10;20;30mbold rgb äöü €\x1b[0m\r\n"
+    "\x1b]0;title\x1b\\\x1b[48:2::1:2:3m\x1b\r\x1b[4mu\x1b[24m 𝄞 \x1b[38;5;82mgreen\x1b[K\n\x1b[7mlast"
+  };
+  AnsiParser whole;
+  whole.parse(input);
+  const auto expected{whole.take()};
+  REQUIRE_EQ(expected.data.size(), 3);
+  for (size_t split = 0; split <= input.size(); ++split) {
+    AnsiParser parser;
+    parser.parse(std::string_view{input}.substr(0, split)).parse(std::string_view{input}.substr(split));
+    CHECK_EQ(parser.take(), expected);
+    CHECK(parser.line() == whole.line());
+  }
+  // One byte at a time
+  AnsiParser parser;
+  for (const auto byte: input) {
+    parser.parse(std::string_view{&byte, 1});
+  }
+  CHECK_EQ(parser.take(), expected);
+  CHECK(parser.line() == whole.line());
+  CHECK(parser.attributes() == whole.attributes());
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
+// NOLINTEND(readability-magic-numbers)
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -12,9 +12,11 @@
 using
   jwezel::blink,
   jwezel::bold,
+  jwezel::Char,
   jwezel::Dim,
   jwezel::Display,
   jwezel::Keyboard,
+  jwezel::Rectangle,
   jwezel::repr,
   jwezel::reverse,
   jwezel::RgbBlue,
@@ -98,6 +100,24 @@ TEST_CASE("Display") {
       disp.update(Vector{0, 0}, Text("::::::::::\n::::::::::\n::::::::::\n::::::::::"));
       disp.update(Vector{1, 1}, Text("++++++++\n++++++++"));
       CHECK_EQ(disp.text().repr(), Text("::::::::::\n:++++++++:\n:++++++++:\n::::::::::").repr());
+      CHECK(disp.fill(Rectangle{7, 2, 20, 20}, Char('-')));
+      CHECK_EQ(disp.text().repr(), Text("::::::::::\n:++++++++:\n:++++++---\n:::::::---").repr());
+    }
+    SUBCASE("Scroll") {
+      disp.resize(Vector{10, 4});
+      disp.update(Vector{0, 0}, Text("0000000000\n1111111111\n2222222222\n3333333333"));
+      CHECK_EQ(fflush(output), 0);
+      ftruncate(output->_fileno, 0);
+      CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+      CHECK(disp.move({Rectangle{0, 1, 10, 4}}, Vector{0, -1}));
+      CHECK_EQ(disp.text().repr(), Text("1111111111\n2222222222\n3333333333\n          ").repr());
+      disp.update(Vector{0, 3}, Text("4"));
+      CHECK(disp.move({Rectangle{0, 0, 10, 2}}, Vector{0, 2}));
+      CHECK_EQ(disp.text().repr(), Text("          \n          \n1111111111\n2222222222").repr());
+      char buffer[BufferSize];
+      CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+      CHECK_NE(fgets(buffer, sizeof buffer, output), nullptr);
+      CHECK_EQ(repr(buffer), repr("\x1b[1;4r\x1b[1S\x1b[r\x1b[4;1H4\x1b[1;4r\x1b[2T\x1b[r"));
     }
     SUBCASE("Resize") {
       disp.resize(Vector{10, 6});
@@ -107,6 +127,73 @@ TEST_CASE("Display") {
     // fclose(output);
     kb.reset();
   }
+  SUBCASE("Keyboard protocol") {
+    auto *output{tmpfile()};
+    auto *input{tmpfile()};
+    CHECK_EQ(fputs("\x1b[1;1R\x1b[1;1R\x1b[20;10R\x1b[?0u\x1b[?62;22c", input), 1);
+    CHECK_EQ(fseek(input, 0, SEEK_SET), 0);
+    Keyboard kb(input->_fileno);
+    Display disp{kb, output->_fileno};
+    CHECK_EQ(fflush(output), 0);
+    ftruncate(output->_fileno, 0);
+    CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+    CHECK(disp.keyboardProtocol(true));
+    CHECK(kb.kittyProtocol());
+    CHECK_FALSE(disp.keyboardProtocol(false));
+    char buffer[BufferSize];
+    CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+    CHECK_NE(fgets(buffer, sizeof buffer, output), nullptr);
+    CHECK_EQ(repr(buffer), repr("\x1b[?u\x1b[c\x1b[>1u\x1b[<u"));
+    kb.reset();
+  }
+  SUBCASE("Keyboard protocol not supported") {
+    auto *output{tmpfile()};
+    auto *input{tmpfile()};
+    CHECK_EQ(fputs("\x1b[1;1R\x1b[1;1R\x1b[20;10R\x1b[?62;22c", input), 1);
+    CHECK_EQ(fseek(input, 0, SEEK_SET), 0);
+    Keyboard kb(input->_fileno);
+    Display disp{kb, output->_fileno};
+    CHECK_FALSE(disp.keyboardProtocol(true));
+    CHECK_FALSE(kb.kittyProtocol());
+    kb.reset();
+  }
+  SUBCASE("Rectangular editing") {
+    auto *output{tmpfile()};
+    auto *input{tmpfile()};
+    CHECK_EQ(fputs("\x1b[1;1R\x1b[1;1R\x1b[20;10R\x1b[?64;1;2;6;9;15;18;21;22;28c", input), 1);
+    CHECK_EQ(fseek(input, 0, SEEK_SET), 0);
+    Keyboard kb(input->_fileno);
+    Display disp{kb, output->_fileno};
+    CHECK(disp.rectangularEditing(true));
+    disp.resize(Vector{10, 4});
+    CHECK_EQ(fflush(output), 0);
+    ftruncate(output->_fileno, 0);
+    CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+    disp.update(Vector{0, 0}, Text("::::::::::\n::::::::::\n::::::::::\n::::::::::"));
+    disp.update(Vector{1, 1}, Text("ab\ncd"));
+    CHECK(disp.move({Rectangle{1, 1, 3, 3}}, Vector{4, 1}));
+    CHECK_EQ(disp.text().repr(), Text("::::::::::\n:ab:::::::\n:cd::ab:::\n:::::cd:::").repr());
+    CHECK_FALSE(disp.move({Rectangle{1, 1, 3, 3}}, Vector{8, 0}));
+    char buffer[BufferSize];
+    CHECK_EQ(fseek(output, 0, SEEK_SET), 0);
+    CHECK_NE(fgets(buffer, sizeof buffer, output), nullptr);
+    CHECK_EQ(
+      repr(buffer),
+      repr("\x1b[39m\x1b[58;1;1;4;10$x\x1b[2;2Hab\x1b[3;2Hcd\x1b[2;2;3;3;1;3;6;1$v")
+    );
+    CHECK_FALSE(disp.rectangularEditing(false));
+    kb.reset();
+  }
+  SUBCASE("Rectangular editing not supported") {
+    auto *output{tmpfile()};
+    auto *input{tmpfile()};
+    CHECK_EQ(fputs("\x1b[1;1R\x1b[1;1R\x1b[20;10R\x1b[?62;22c", input), 1);
+    CHECK_EQ(fseek(input, 0, SEEK_SET), 0);
+    Keyboard kb(input->_fileno);
+    Display disp{kb, output->_fileno};
+    CHECK_FALSE(disp.rectangularEditing(true));
+    kb.reset();
+  }
 }
 TEST_CASE("Optional tests" * doctest::skip(true)) {
   SUBCASE("Real") {
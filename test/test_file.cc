@@ -0,0 +1,168 @@
+#include <term/file.hh>
+#include <term/geometry.hh>
+#include <term/surface.hh>
+#include <term/text.hh>
+#include <term/window.hh>
+
+#include <chrono>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+#include "screen.hh"
+
+using
+  jwezel::Backdrop,
+  jwezel::Char,
+  jwezel::Dim,
+  jwezel::FileElement,
+  jwezel::Rectangle,
+  jwezel::RgbRed,
+  jwezel::String,
+  jwezel::Surface,
+  jwezel::Text,
+  jwezel::Vector;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+// NOLINTBEGIN(readability-magic-numbers)
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+namespace {
+
+// Temporary file removed at the end of the test
+struct TemporaryFile {
+  explicit TemporaryFile(const std::string &content):
+  path{std::filesystem::temp_directory_path() / std::format("test_file_{}", ::getpid())}
+  {
+    std::ofstream{path, std::ios::binary} << content;
+  }
+  TemporaryFile(const TemporaryFile &) = delete;
+  TemporaryFile(TemporaryFile &&) = delete;
+  auto operator=(const TemporaryFile &) -> TemporaryFile & = delete;
+  auto operator=(TemporaryFile &&) -> TemporaryFile & = delete;
+  ~TemporaryFile() {
+    std::filesystem::remove(path);
+  }
+  void append(const std::string &content) const {
+    std::ofstream{path, std::ios::binary | std::ios::app} << content;
+  }
+  std::filesystem::path path;
+};
+
+} // namespace
+
+TEST_CASE("File element") {
+  ShiftingScreen screen{Vector{20, 8}};
+  Surface surface{&screen};
+  Backdrop backdrop{&surface};
+  TemporaryFile file{"one\ntwo\tx\r\nthree äöü and more\nbad \xff\x01\n"};
+  FileElement view{&surface, Rectangle{2, 2, 12, 6}, file.path.string()};
+  const auto check{[&]() {
+    Text expected{Char(' '), Vector{20, 8}};
+    expected.patch(view.text(), view.area().position());
+    CHECK_EQ(screen.text_.repr(), expected.repr());
+  }};
+  SUBCASE("Render") {
+    CHECK(view.indexed());
+    CHECK_EQ(view.lines(), 4);
+    CHECK_EQ(view.line(1), "two\tx");
+    CHECK_THROWS_AS((void)view.line(4), std::out_of_range);
+    CHECK_EQ(view.text().repr(), Text("one       \ntwo     x \nthree äöü \nbad ��    ").repr());
+    CHECK_EQ(view.text(Rectangle{6, 2, 9, 3}).repr(), Text("äöü").repr());
+    check();
+    view.top(2);
+    CHECK_EQ(view.text().repr(), Text("three äöü \nbad ��    \n          \n          ").repr());
+    check();
+  }
+  SUBCASE("Styler") {
+    view.styler([](size_t number, String &line) {
+      if (number == 1 and !line.empty()) {
+        line[0] = Char(line[0].rune, RgbRed);
+      }
+    });
+    Text expected{"one\ntwo"};
+    expected.data[1][0] = Char('t', RgbRed);
+    CHECK_EQ(view.text(Rectangle{0, 0, 3, 2}), expected);
+    check();
+  }
+  SUBCASE("Tail") {
+    CHECK_FALSE(view.refresh());
+    view.follow(true);
+    CHECK_EQ(view.top(), 0);
+    file.append("partial");
+    CHECK(view.refresh());
+    CHECK_EQ(view.lines(), 5);
+    CHECK_EQ(view.top(), 1);
+    check();
+    file.append(" line\n");
+    CHECK(view.refresh());
+    CHECK_EQ(view.line(4), "partial line");
+    check();
+    for (auto i = 0; i < 20; ++i) {
+      file.append(std::format("line {}\n", i));
+      CHECK(view.refresh());
+      check();
+    }
+    CHECK_EQ(view.top(), 21);
+    CHECK_EQ(view.text().repr(), Text("line 16   \nline 17   \nline 18   \nline 19   ").repr());
+    CHECK_GT(screen.moves_, 15);
+    // Not following keeps the view
+    view.top(3);
+    file.append("more\n");
+    CHECK(view.refresh());
+    CHECK_EQ(view.top(), 3);
+    check();
+  }
+  SUBCASE("Shrink") {
+    std::filesystem::resize_file(file.path, 4);
+    CHECK(view.refresh());
+    CHECK_EQ(view.lines(), 1);
+    CHECK_EQ(view.text().repr(), Text("one       \n          \n          \n          ").repr());
+    check();
+  }
+}
+
+TEST_CASE("File element errors") {
+  ShiftingScreen screen{Vector{20, 8}};
+  Surface surface{&screen};
+  CHECK_THROWS_AS(FileElement(&surface, Rectangle{0, 0, 10, 4}, "/nonexistent/file"), std::system_error);
+}
+
+TEST_CASE("File element indexing") {
+  ShiftingScreen screen{Vector{20, 8}};
+  Surface surface{&screen};
+  Backdrop backdrop{&surface};
+  const size_t lines{1'500'000};
+  std::string content;
+  for (size_t i = 0; i < lines; ++i) {
+    content += std::format("line {}\n", 1'000'000 + i);
+  }
+  REQUIRE(content.size() > FileElement::BackgroundSize);
+  TemporaryFile file{content};
+  FileElement view{&surface, Rectangle{0, 0, 20, 8}, file.path.string()};
+  CHECK_EQ(view.text(Rectangle{0, 0, 12, 1}).repr(), Text("line 1000000").repr());
+  // Lines far ahead are indexed on demand while the rest is indexed in the background
+  view.top(1'000'000);
+  CHECK_EQ(view.text(Rectangle{0, 0, 12, 1}).repr(), Text("line 2000000").repr());
+  while (!view.indexed()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  view.refresh();
+  CHECK_EQ(view.lines(), lines);
+  CHECK_EQ(view.line(lines - 1), "line 2499999");
+  view.follow(true);
+  CHECK_EQ(view.top(), lines - 8);
+  Text expected{Char(' '), Vector{20, 8}};
+  expected.patch(view.text(), Vector{0, 0});
+  CHECK_EQ(screen.text_.repr(), expected.repr());
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
+// NOLINTEND(readability-magic-numbers)
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <doctest/doctest.h>
 #include <iostream>
+#include <string_view>
 
 using jwezel::Key;
 
@@ -13,10 +14,15 @@ TEST_CASE("Keyboard") {
   (void)fputs("\x1b\x0d\x1b\x1b\x1bO_\x1b[D\x1b[\xff\xff\xff""Dx", tmpFile); // \xff bytes simulate a delay
   (void)fseek(tmpFile, 0, SEEK_SET);
   jwezel::Keyboard kb(tmpFile->_fileno);
-  CHECK_EQ(kb.keyPrefixes().nodes.at('\x7f')->key, Key::Backspace);
-  CHECK_EQ(kb.keyPrefixes().nodes.at('\x1b')->nodes['\x0d']->key, Key::AltEnter);
-  CHECK_EQ(kb.keyPrefixes().nodes.at('\x1b')->nodes['\x0d']->nodes.size(), 0);
-  CHECK_EQ(kb.keyPrefixes().nodes.at('\x1b')->nodes.size(), 6);
+  const auto &prefixes{kb.keyPrefixes()};
+  REQUIRE_NE(prefixes.child(prefixes.root(), '\x7f'), nullptr);
+  CHECK_EQ(prefixes.child(prefixes.root(), '\x7f')->key, Key::Backspace);
+  const auto *escape{prefixes.child(prefixes.root(), '\x1b')};
+  REQUIRE_NE(escape, nullptr);
+  CHECK_EQ(prefixes.child(*escape, '\x0d')->key, Key::AltEnter);
+  CHECK_EQ(prefixes.child(*escape, '\x0d')->childCount, 0);
+  CHECK_EQ(escape->childCount, 6);
+  CHECK_EQ(prefixes.child(*escape, 'x'), nullptr);
   SUBCASE("Read key") {
     CHECK_EQ(kb.key(), jwezel::Key::AltEnter);
     CHECK_EQ(kb.key(), '\x1b');
@@ -33,6 +39,52 @@ TEST_CASE("Keyboard") {
   (void)fclose(tmpFile);
 }
 
+TEST_CASE("Keyboard UTF-8") {
+  auto *tmpFile{tmpfile()};
+  (void)fputs("abc\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\xc3(\x1b[Aprintable ASCII run\x7f\xc0\xaf\xaf", tmpFile);
+  (void)fseek(tmpFile, 0, SEEK_SET);
+  jwezel::Keyboard kb(tmpFile->_fileno);
+  CHECK_EQ(kb.key(), 'a');
+  CHECK_EQ(kb.key(), 'b');
+  CHECK_EQ(kb.key(), 'c');
+  CHECK_EQ(kb.key(), U'ä');
+  CHECK_EQ(kb.key(), U'€');
+  CHECK_EQ(kb.key(), U'😀');
+  CHECK_EQ(kb.key(), 0xfffd);  // truncated sequence
+  CHECK_EQ(kb.key(), '(');
+  CHECK_EQ(kb.key(), jwezel::Key::Up);
+  for (const auto ch: std::string_view{"printable ASCII run"}) {
+    CHECK_EQ(kb.key(), static_cast<jwezel::Unicode>(ch));
+  }
+  CHECK_EQ(kb.key(), jwezel::Key::Backspace);
+  CHECK_EQ(kb.key(), 0xfffd);  // overlong encoding
+  CHECK_EQ(kb.key(), 0xfffd);  // stray continuation byte
+  (void)fclose(tmpFile);
+}
+
+TEST_CASE("Keyboard kitty protocol") {
+  auto *tmpFile{tmpfile()};
+  (void)fputs("\x1b[27u\x1b[97;5u\x1b[97;3u\x1b[13;2u\x1b[1;3A\x1b[15;5~\x1b[1;5P\x1b\x1b[Dx", tmpFile);
+  (void)fseek(tmpFile, 0, SEEK_SET);
+  jwezel::Keyboard kb(tmpFile->_fileno);
+  kb.kittyProtocol(true);
+  CHECK_EQ(kb.key(), '\x1b');
+  CHECK_FALSE(kb.modifiers().control);
+  CHECK_EQ(kb.key(), '\x01');
+  CHECK(kb.modifiers().control);
+  CHECK_EQ(kb.key(), 'a');
+  CHECK(kb.modifiers().alt);
+  CHECK_EQ(kb.key(), jwezel::Key::ShiftEnter);
+  CHECK(kb.modifiers().shift);
+  CHECK_EQ(kb.key(), jwezel::Key::AltUp);
+  CHECK_EQ(kb.key(), jwezel::Key::CtrlF5);
+  CHECK_EQ(kb.key(), jwezel::Key::CtrlF1);
+  CHECK_EQ(kb.key(), jwezel::Key::AltLeft);
+  CHECK_EQ(kb.key(), 'x');
+  CHECK_FALSE(kb.modifiers().alt);
+  (void)fclose(tmpFile);
+}
+
 TEST_CASE("Real user-operated keyboard" * doctest::skip(true)) {
   jwezel::Keyboard kb;
   std::cout << "Press F1\n";
@@ -0,0 +1,136 @@
+#include <term/geometry.hh>
+#include <term/log.hh>
+#include <term/surface.hh>
+#include <term/text.hh>
+#include <term/window.hh>
+
+#include <doctest/doctest.h>
+#include <format>
+#include <stdexcept>
+
+#include "screen.hh"
+
+using
+  jwezel::Backdrop,
+  jwezel::Char,
+  jwezel::CharAttributes,
+  jwezel::Dim,
+  jwezel::LogElement,
+  jwezel::Rectangle,
+  jwezel::Rgb,
+  jwezel::RgbRed,
+  jwezel::Surface,
+  jwezel::Text,
+  jwezel::Vector;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+// NOLINTBEGIN(readability-magic-numbers)
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+namespace {
+
+auto lines(const LogElement &log) -> std::string {
+  return log.text().repr();
+}
+
+} // namespace
+
+TEST_CASE("Log element") {
+  ShiftingScreen screen{Vector{20, 8}};
+  Surface surface{&screen};
+  Backdrop backdrop{&surface};
+  LogElement log{&surface, Rectangle{2, 2, 12, 6}};
+  const auto check{[&]() {
+    Text expected{Char(' '), Vector{20, 8}};
+    expected.patch(log.text(), log.area().position());
+    CHECK_EQ(screen.text_.repr(), expected.repr());
+  }};
+  SUBCASE("Append") {
+    log.append("one").append("two");
+    CHECK_EQ(lines(log), Text("one       \ntwo       \n          \n          ").repr());
+    check();
+    log.append("three äöü and more");
+    CHECK_EQ(log.line(2).repr(), Text("three äöü and more").repr());
+    CHECK_EQ(log.text(Rectangle{6, 2, 9, 3}).repr(), Text("äöü").repr());
+    check();
+  }
+  SUBCASE("Follow") {
+    for (auto i = 0; i < 100; ++i) {
+      log.append(std::format("line {}", i));
+      check();
+    }
+    CHECK_EQ(log.top(), 96);
+    CHECK_EQ(lines(log), Text("line 96   \nline 97   \nline 98   \nline 99   ").repr());
+    CHECK_GT(screen.moves_, 90);
+    log.top(10);
+    CHECK_FALSE(log.follow());
+    CHECK_EQ(lines(log), Text("line 10   \nline 11   \nline 12   \nline 13   ").repr());
+    check();
+    log.top(12);
+    check();
+    log.append("line 100");
+    CHECK_EQ(log.top(), 12);
+    check();
+    log.follow(true);
+    CHECK_EQ(log.top(), 97);
+    check();
+    log.top(1000);
+    CHECK_EQ(log.top(), 100);
+    check();
+  }
+  SUBCASE("Styles") {
+    Text styled{"ab"};
+    styled.data[0][1] = Char('b', CharAttributes{RgbRed});
+    log.append(styled);
+    log.append("plain", CharAttributes{RgbRed});
+    CHECK_EQ(log.line(0), styled);
+    CHECK_EQ(log.line(1), Text("plain", RgbRed));
+    check();
+  }
+  SUBCASE("Control characters") {
+    log.append("a\tb\x01");
+    Text tabbed{"xzy"};
+    tabbed.data[0][1] = Char('\t');
+    log.append(tabbed);
+    CHECK_EQ(log.line(0).repr(), Text("a       b\xef\xbf\xbd").repr());
+    CHECK_EQ(log.line(1).repr(), Text("x       y").repr());
+    check();
+  }
+}
+
+TEST_CASE("Log element retention") {
+  ShiftingScreen screen{Vector{20, 8}};
+  Surface surface{&screen};
+  Backdrop backdrop{&surface};
+  LogElement log{&surface, Rectangle{0, 0, 20, 8}, 3000};
+  for (auto i = 0; i < 20000; ++i) {
+    log.append(std::format("line {}", i));
+  }
+  CHECK_EQ(log.end(), 20000);
+  CHECK_GE(log.end() - log.first(), 3000);
+  CHECK_LE(log.end() - log.first(), 3000 + 2 * LogElement::PageLines);
+  CHECK_EQ(log.first() % LogElement::PageLines, 0);
+  CHECK_EQ(log.line(log.first()).repr(), Text(std::format("line {}", log.first())).repr());
+  CHECK_EQ(log.line(19999).repr(), Text("line 19999").repr());
+  CHECK_THROWS_AS((void)log.line(0), std::out_of_range);
+  log.top(0);
+  CHECK_EQ(log.top(), log.first());
+  // Dropping the lines shown moves the view to the oldest line kept
+  for (auto i = 0; i < 5000; ++i) {
+    log.append("more");
+  }
+  CHECK_EQ(log.top(), log.first());
+  Text expected{Char(' '), Vector{20, 8}};
+  expected.patch(log.text(), Vector{0, 0});
+  CHECK_EQ(screen.text_.repr(), expected.repr());
+  // Styles are kept with the pages using them
+  for (auto i = 0; i < 5000; ++i) {
+    log.append("c", CharAttributes{Rgb{jwezel::f4(i) / 5000, 0.5F, 0.5F}});
+  }
+  CHECK_EQ(log.line(27000), Text("c", Rgb{jwezel::f4(2000) / 5000, 0.5F, 0.5F}));
+  CHECK_EQ(log.line(log.end() - 1), Text("c", Rgb{jwezel::f4(4999) / 5000, 0.5F, 0.5F}));
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
+// NOLINTEND(readability-magic-numbers)
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,121 @@
+#include <term/geometry.hh>
+#include <term/region.hh>
+
+#include <vector>
+#include <doctest/doctest.h>
+
+#include "random.hh"
+
+using
+  jwezel::DimHigh,
+  jwezel::Rectangle,
+  jwezel::Region,
+  jwezel::string,
+  jwezel::Vector;
+using std::vector;
+
+namespace doctest {
+  template<> struct StringMaker<Region> {
+    static auto convert(const Region& value) -> String {
+      return string(value).c_str();
+    }
+  };
+} // namespace doctest
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+// NOLINTBEGIN(readability-magic-numbers)
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+namespace {
+auto cells(const Region &region) -> long {
+  long result{0};
+  for (const auto &rectangle: region) {
+    result += long(rectangle.width()) * rectangle.height();
+  }
+  return result;
+}
+} // namespace
+
+TEST_CASE("Region") {
+  const Region r1{Rectangle{0, 0, 4, 4}};
+  const Region r2{Rectangle{2, 2, 6, 6}};
+  SUBCASE("Constructor") {
+    CHECK(Region{}.empty());
+    CHECK(Region{Rectangle{1, 1, 1, 5}}.empty());
+    CHECK_EQ(r1.size(), 1);
+    CHECK_EQ(Region{Rectangle{0, 0, 2, 1}, Rectangle{2, 0, 4, 1}, Rectangle{0, 1, 4, 2}}, Region{Rectangle{0, 0, 4, 2}});
+  }
+  SUBCASE("Union") {
+    const auto region{r1 | r2};
+    CHECK_EQ(
+      vector<Rectangle>(region.begin(), region.end()),
+      vector<Rectangle>{Rectangle{0, 0, 4, 2}, Rectangle{0, 2, 6, 4}, Rectangle{2, 4, 6, 6}}
+    );
+    CHECK_EQ(cells(region), 28);
+    CHECK_EQ(region.bounds(), Rectangle{0, 0, 6, 6});
+    CHECK_EQ(r1 | Region{Rectangle{4, 0, 8, 4}}, Region{Rectangle{0, 0, 8, 4}});
+    CHECK_EQ(r1 | Region{Rectangle{0, 4, 4, 8}}, Region{Rectangle{0, 0, 4, 8}});
+  }
+  SUBCASE("Intersection") {
+    CHECK_EQ(r1 & r2, Region{Rectangle{2, 2, 4, 4}});
+    CHECK((r1 & Region{Rectangle{4, 0, 8, 4}}).empty());
+  }
+  SUBCASE("Difference") {
+    const auto region{r1 - r2};
+    CHECK_EQ(
+      vector<Rectangle>(region.begin(), region.end()),
+      vector<Rectangle>{Rectangle{0, 0, 4, 2}, Rectangle{0, 2, 2, 4}}
+    );
+    CHECK_EQ(Region{Rectangle{0, 0, 9, 9}} - Region{Rectangle{3, 3, 6, 6}} | Region{Rectangle{3, 3, 6, 6}}, Region{Rectangle{0, 0, 9, 9}});
+    CHECK((r1 - r1).empty());
+    CHECK_EQ(r1 - Region{Rectangle{8, 8, 9, 9}}, r1);
+    const auto hole{Region{Rectangle{0, 0, DimHigh, DimHigh}} - Region{Rectangle{1, 1, 9, 5}}};
+    CHECK_EQ(
+      vector<Rectangle>(hole.begin(), hole.end()),
+      vector<Rectangle>{
+        Rectangle{0, 0, DimHigh, 1}, Rectangle{0, 1, 1, 5}, Rectangle{9, 1, DimHigh, 5}, Rectangle{0, 5, DimHigh, DimHigh}
+      }
+    );
+  }
+  SUBCASE("Translation") {
+    CHECK_EQ(r1 + Vector{2, 3}, Region{Rectangle{2, 3, 6, 7}});
+  }
+  SUBCASE("Intersects") {
+    CHECK((r1 | r2).intersects(Rectangle{5, 5, 7, 7}));
+    CHECK_FALSE((r1 | r2).intersects(Rectangle{0, 4, 2, 6}));
+  }
+  SUBCASE("Random") {
+    // Compare with cell by cell evaluation
+    Random random{7};
+    for (auto round = 0; round < 50; ++round) {
+      vector<Rectangle> rectangles1;
+      vector<Rectangle> rectangles2;
+      for (auto i = 0; i < 5; ++i) {
+        for (auto *rectangles: {&rectangles1, &rectangles2}) {
+          const auto x{jwezel::Dim(random(12))}, y{jwezel::Dim(random(12))};
+          rectangles->emplace_back(x, y, jwezel::Dim(x + 1 + random(6)), jwezel::Dim(y + 1 + random(6)));
+        }
+      }
+      const Region a{rectangles1}, b{rectangles2};
+      const auto inside{[](const Region &region, int x, int y) {
+        return region.intersects(Rectangle{jwezel::Dim(x), jwezel::Dim(y), jwezel::Dim(x + 1), jwezel::Dim(y + 1)});
+      }};
+      const auto aOrB{a | b}, aAndB{a & b}, aMinusB{a - b};
+      auto correct{true};
+      for (auto y = 0; y < 20; ++y) {
+        for (auto x = 0; x < 20; ++x) {
+          correct = correct and
+            inside(aOrB, x, y) == (inside(a, x, y) or inside(b, x, y)) and
+            inside(aAndB, x, y) == (inside(a, x, y) and inside(b, x, y)) and
+            inside(aMinusB, x, y) == (inside(a, x, y) and !inside(b, x, y));
+        }
+      }
+      CHECK(correct);
+      CHECK_EQ((aOrB - b) | aAndB, a);
+    }
+  }
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
+// NOLINTEND(readability-magic-numbers)
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -10,16 +10,26 @@
 #include <algorithm>
 #include <format>
 #include <iterator>
+#include <memory>
+#include <optional>
 #include <ranges>
 #include <vector>
 
 #include <doctest/doctest.h>
 
+#include "random.hh"
+#include "screen.hh"
+
 using
   jwezel::Char,
   jwezel::Dim,
   jwezel::DimHigh,
+  jwezel::DimLow,
+  jwezel::FragmentHandle,
+  jwezel::FragmentIndex,
+  jwezel::GridIndex,
   jwezel::Rectangle,
+  jwezel::RtreeIndex,
   jwezel::str,
   jwezel::string,
   jwezel::Text,
@@ -28,7 +38,7 @@ using
   jwezel::Vector,
   jwezel::operator""_C;
 
-using jwezel::Surface, jwezel::Window, jwezel::Backdrop;
+using jwezel::Surface, jwezel::Window, jwezel::Backdrop, jwezel::ProceduralElement;
 using std::vector, std::copy, std::back_inserter;
 using std::ranges::views::transform, std::ranges::views::join_with;
 
@@ -106,20 +116,26 @@ struct Terminal: Surface, jwezel::TerminalInterface {
   Backdrop backdrop_;
 };
 
+// Get fragment at position
+auto FindFragment(const Surface &screen, const Vector &position) -> std::optional<Surface::Fragment> {
+  const auto *fragment{screen.find(position)};
+  return fragment? std::optional{*fragment}: std::nullopt;
+}
+
 // Test rtree: check whether all corners of all fragments can be found in rtree
 void TestRtree(const Surface &screen) {
   for (const auto *element: screen.zorder()) {
     for (const auto &fr: element->fragments()) {
       const auto &fa{fr.area};
-      CHECK_EQ(screen.find(fa.position()), &fr);
+      CHECK_EQ(FindFragment(screen, fa.position()), fr);
       if (fa.x2() > fa.x1()) {
-        CHECK_EQ(screen.find(Vector{Dim(fa.x2() - 1), fa.y1()}), &fr);
+        CHECK_EQ(FindFragment(screen, Vector{Dim(fa.x2() - 1), fa.y1()}), fr);
         if (fa.y2() > fa.y1()) {
-          CHECK_EQ(screen.find(Vector{Dim(fa.x2() - 1), Dim(fa.y2() - 1)}), &fr);
+          CHECK_EQ(FindFragment(screen, Vector{Dim(fa.x2() - 1), Dim(fa.y2() - 1)}), fr);
         }
       } else {
         if (fa.y2() > fa.y1()) {
-          CHECK_EQ(screen.find(Vector{fa.x1(), Dim(fa.y2() - 1)}), &fr);
+          CHECK_EQ(FindFragment(screen, Vector{fa.x1(), Dim(fa.y2() - 1)}), fr);
         }
       }
     }
@@ -185,11 +201,11 @@ TEST_CASE("Surface") {
           Surface::Fragment{Rectangle{0, 6, DimHigh, DimHigh}, scr.zorder()[0]}
         }
       );
-      CHECK_EQ(scr.find(Vector{0, 0}), &term.backdrop_.fragments()[0]);
-      CHECK_EQ(scr.find(Vector{1, 1}), &win1.fragments()[0]);
-      CHECK_EQ(scr.find(Vector{8, 1}), &win1.fragments()[0]);
-      CHECK_EQ(scr.find(Vector{2, 0}), &win2.fragments()[0]);
-      CHECK_EQ(scr.find(Vector{2, 5}), &win2.fragments()[1]);
+      CHECK_EQ(FindFragment(scr, Vector{0, 0}), term.backdrop_.fragments()[0]);
+      CHECK_EQ(FindFragment(scr, Vector{1, 1}), win1.fragments()[0]);
+      CHECK_EQ(FindFragment(scr, Vector{8, 1}), win1.fragments()[0]);
+      CHECK_EQ(FindFragment(scr, Vector{2, 0}), win2.fragments()[0]);
+      CHECK_EQ(FindFragment(scr, Vector{2, 5}), win2.fragments()[1]);
       auto expupdates2{Updates{{Vector{2, 0}, Text("......")}, {Vector{2, 5}, Text("......")}}};
       CHECK_EQ(dev.updates_, expupdates2);
       CHECK_EQ(scr.zorder().size(), 3);
@@ -339,6 +355,525 @@ TEST_CASE("Surface") {
   }
 }
 
+// Screen filling uniform areas itself
+struct FillingScreen: Screen {
+  using Screen::Screen;
+  auto fill(const Rectangle &area, const Char &ch) -> bool override {
+    const auto visible{area & Rectangle{Vector{0, 0}, text_.size()}};
+    if (visible) {
+      text_.fill(ch, visible.value());
+      filled_ += visible->width() * visible->height();
+    }
+    return true;
+  }
+  int filled_{0};
+};
+
+struct ScreenTerminal: Surface, jwezel::TerminalInterface {
+  explicit ScreenTerminal(Screen &screen, Surface::Compositor compositor):
+  Surface{&screen}
+  {
+    this->compositor(compositor);
+    backdrop_ = std::make_unique<Backdrop>(this);
+  }
+  ~ScreenTerminal() override = default;
+  ScreenTerminal(const ScreenTerminal &) = delete;
+  ScreenTerminal(ScreenTerminal &&) = delete;
+  auto operator=(const ScreenTerminal &) -> ScreenTerminal & = delete;
+  auto operator=(ScreenTerminal &&) -> ScreenTerminal & = delete;
+  void focus(struct Window */*window*/) override {}
+  auto surface() -> Surface * override { return this;}
+  auto expand(const Vector &/*size*/) -> bool override {return false;}
+  auto contract() -> bool override {return false;}
+  void moveWindow(Window &/*window*/, const Rectangle & /*area*/) override {}
+
+  std::unique_ptr<Backdrop> backdrop_;
+};
+
+TEST_CASE("Surface fragment coalescing") {
+  Device dev;
+  Terminal term{dev};
+  Surface &scr{*term.surface()};
+  Window win1{&term, Rectangle{2, 2, 6, 4}};
+  Window win2{&term, Rectangle{2, 4, 6, 6}};
+  const vector<Surface::Fragment> expected{
+    Surface::Fragment{Rectangle{0, 0, DimHigh, 2}, &term.backdrop_},
+    Surface::Fragment{Rectangle{0, 2, 2, 6}, &term.backdrop_},
+    Surface::Fragment{Rectangle{6, 2, DimHigh, 6}, &term.backdrop_},
+    Surface::Fragment{Rectangle{0, 6, DimHigh, DimHigh}, &term.backdrop_}
+  };
+  CHECK_EQ(term.backdrop_.fragments(), expected);
+  CHECK_EQ(term.backdrop_.fragmentCount(), 4);
+  CHECK_EQ(scr.fragmentCount(), 6);
+  TestRtree(scr);
+  SUBCASE("Move") {
+    win1.move(Rectangle{2, 2, 6, 5});
+    win1.move(Rectangle{2, 2, 6, 4});
+    CHECK_EQ(term.backdrop_.fragments(), expected);
+    TestRtree(scr);
+  }
+  SUBCASE("Ownership map") {
+    scr.compositor(Surface::Compositor::ownershipMap);
+    CHECK_EQ(term.backdrop_.fragments(), expected);
+    CHECK_EQ(scr.fragmentCount(), 6);
+  }
+}
+
+TEST_CASE("Surface compositors") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    for (const auto index: {Surface::SpatialIndex::rtree, Surface::SpatialIndex::grid}) {
+      INFO("Compositor: ", int(compositor), ", index: ", int(index));
+      Screen screen{size};
+      ScreenTerminal term{screen, compositor};
+      term.spatialIndex(index);
+      Random random{1};
+      const auto randomArea{[&random, &size]() {
+        const auto x1{Dim(random(size.x() - 1))}, y1{Dim(random(size.y() - 1))};
+        return Rectangle{x1, y1, Dim(x1 + 1 + random(size.x() - x1)), Dim(y1 + 1 + random(size.y() - y1))};
+      }};
+      vector<std::unique_ptr<Window>> windows;
+      for (auto i = 0; i < 12; ++i) {
+        windows.push_back(std::make_unique<Window>(&term, randomArea(), Char('a' + i)));
+      }
+      for (auto step = 0; step < 200; ++step) {
+        auto &window{windows[random(int(windows.size()))]};
+        switch (random(4)) {
+          case 0:
+          window->move(randomArea());
+          break;
+
+          case 1:
+          term.above(window.get(), term.zorder().back());
+          break;
+
+          case 2:
+          term.below(window.get(), term.zorder()[1]);
+          break;
+
+          default:
+          window = std::make_unique<Window>(&term, randomArea(), Char('a' + random(26)));
+          break;
+        }
+        const auto expected{ExpectedScreen(term, size)};
+        INFO("Step ", step);
+        REQUIRE_EQ(screen.text_.repr(), expected.repr());
+        TestRtree(term);
+        size_t fragments{0};
+        for (const auto *element: term.zorder()) {
+          fragments += element->fragmentCount();
+        }
+        CHECK_EQ(term.fragmentCount(), fragments);
+        for (size_t pos = 0; pos < term.zorder().size(); ++pos) {
+          REQUIRE_EQ(term.position(term.zorder()[pos]), int(pos));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Surface transactions") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    Screen screen{size};
+    ScreenTerminal term{screen, compositor};
+    auto doomed{std::make_unique<Window>(&term, Rectangle{5, 5, 20, 12}, Char('x'))};
+    vector<std::unique_ptr<Window>> windows;
+    screen.calls_ = 0;
+    {
+      const Surface::Transaction transaction{term};
+      for (auto i = 0; i < 10; ++i) {
+        windows.push_back(std::make_unique<Window>(&term, Rectangle{Dim(i * 3), Dim(i), Dim(i * 3 + 4), Dim(i + 3)}, Char('a' + i)));
+      }
+      {
+        const Surface::Transaction nested{term};
+        windows[2]->write(Vector{0, 0}, "hi");
+        doomed.reset();
+      }
+      CHECK(term.inTransaction());
+      windows[9]->move(Rectangle{1, 10, 5, 13});
+      windows[3]->above(windows[4].get());
+      CHECK_EQ(screen.calls_, 0);
+    }
+    CHECK_FALSE(term.inTransaction());
+    CHECK_EQ(screen.calls_, 1);
+    CHECK_EQ(screen.text_.repr(), ExpectedScreen(term, size).repr());
+    TestRtree(term);
+    size_t fragments{0};
+    for (const auto *element: term.zorder()) {
+      fragments += element->fragmentCount();
+    }
+    CHECK_EQ(term.fragmentCount(), fragments);
+  }
+  Device device;
+  Terminal term{device};
+  CHECK_THROWS_AS(term.commit(), std::logic_error);
+}
+
+TEST_CASE("Surface moves on device") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    ShiftingScreen screen{size};
+    ScreenTerminal term{screen, compositor};
+    vector<std::unique_ptr<Window>> windows;
+    for (auto i = 0; i < 4; ++i) {
+      windows.push_back(std::make_unique<Window>(&term, Rectangle{Dim(i * 6), Dim(i * 3), Dim(i * 6 + 9), Dim(i * 3 + 5)}, Char('a' + i)));
+      windows.back()->write(Vector{1, 1}, std::format("w{}", i));
+    }
+    Random random{1};
+    for (auto step = 0; step < 100; ++step) {
+      auto &window{windows[random(int(windows.size()))]};
+      const auto area{window->area()};
+      const Vector offset{Dim(random(5) - 2), Dim(random(3) - 1)};
+      const auto moved{area + offset};
+      if (moved.x1() >= 0 and moved.y1() >= 0 and moved.x2() <= size.x() and moved.y2() <= size.y()) {
+        window->move(moved);
+      }
+      const auto expected{ExpectedScreen(term, size)};
+      INFO("Step ", step);
+      REQUIRE_EQ(screen.text_.repr(), expected.repr());
+    }
+    CHECK_GT(screen.moved_, 0);
+  }
+}
+
+TEST_CASE("Surface moves in transactions") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    ShiftingScreen screen{size};
+    ScreenTerminal term{screen, compositor};
+    vector<std::unique_ptr<Window>> windows;
+    for (auto i = 0; i < 4; ++i) {
+      windows.push_back(std::make_unique<Window>(&term, Rectangle{Dim(i * 6), Dim(i * 3), Dim(i * 6 + 9), Dim(i * 3 + 5)}, Char('a' + i)));
+      windows.back()->write(Vector{1, 1}, std::format("w{}", i));
+    }
+    const auto check{[&]() {
+      REQUIRE_EQ(screen.text_.repr(), ExpectedScreen(term, size).repr());
+    }};
+    Random random{1};
+    for (auto step = 0; step < 100; ++step) {
+      INFO("Step ", step);
+      {
+        // Several changes per frame, windows may leave the screen partly
+        const Surface::Transaction transaction{term};
+        for (auto change = random(4); change >= 0; --change) {
+          auto &window{windows[random(int(windows.size()))]};
+          switch (random(4)) {
+            case 0:
+            case 1:
+            window->move(window->area() + Vector{Dim(random(5) - 2), Dim(random(3) - 1)});
+            break;
+
+            case 2:
+            window->scroll(Rectangle{0, 1, 9, 5}, Dim(random(3) - 1));
+            window->write(Vector{0, 4}, std::format("{}", step));
+            break;
+
+            default:
+            term.above(window.get(), term.zorder().back());
+            break;
+          }
+        }
+      }
+      check();
+    }
+    CHECK_GT(screen.moved_, 0);
+    // Moves are clipped to the screen
+    Window edge{&term, Rectangle{25, 10, 35, 13}, Char('e')};
+    edge.write(Vector{0, 1}, "edge");
+    const auto moved{screen.moved_};
+    edge.move(Rectangle{24, 11, 34, 14});
+    check();
+    CHECK_GT(screen.moved_, moved);
+  }
+}
+
+TEST_CASE("Surface fills") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    FillingScreen screen{size};
+    ScreenTerminal term{screen, compositor};
+    CHECK_EQ(term.backdrop_->uniform(Rectangle{0, 0, 5, 5}), jwezel::Space);
+    Window window1{&term, Rectangle{2, 2, 12, 8}, Char('a')};
+    Window window2{&term, Rectangle{8, 5, 20, 10}, Char('b')};
+    CHECK_FALSE(window1.uniform(Rectangle{0, 0, 2, 2}));
+    window1.write(Vector{1, 1}, "w1");
+    for (const auto &area: {Rectangle{10, 3, 20, 9}, Rectangle{0, 0, 10, 6}, Rectangle{15, 8, 25, 14}}) {
+      window1.move(area);
+      const auto expected{ExpectedScreen(term, size)};
+      INFO("Area ", string(area));
+      REQUIRE_EQ(screen.text_.repr(), expected.repr());
+    }
+    CHECK_GT(screen.filled_, 0);
+  }
+}
+
+TEST_CASE("Procedural element") {
+  const Vector size{30, 15};
+  Screen screen{size};
+  ScreenTerminal term{screen, Surface::Compositor::fragments};
+  // Ruler with a digit every column and a mark every ten columns
+  auto mark{'|'};
+  Dim widest{0};
+  const auto ruler{[&mark, &widest](const Rectangle &area) {
+    widest = std::max(widest, area.width());
+    Text result{Char(' '), area.size()};
+    for (auto y = area.y1(); y < area.y2(); ++y) {
+      for (auto x = area.x1(); x < area.x2(); ++x) {
+        result[Vector{Dim(x - area.x1()), Dim(y - area.y1())}] = Char(y == 0? '0' + x % 10: x % 10? ' ': mark);
+      }
+    }
+    return result;
+  }};
+  ProceduralElement timeline{&term, Rectangle{-5000, 2, 5000, 5}, ruler};
+  Window window{&term, Rectangle{4, 3, 10, 8}, Char('w')};
+  const auto check{[&]() {
+    CHECK_EQ(screen.text_.repr(), ExpectedScreen(term, size).repr());
+  }};
+  check();
+  CHECK_EQ(timeline.text(Rectangle{9998, 0, 10002, 2}).repr(), Text("89\n  ").repr());
+  CHECK_EQ(timeline.text(Rectangle{-3, -3, 2, 2}).repr(), Text("01\n| ").repr());
+  timeline.move(Rectangle{-4997, 1, 5003, 4});
+  check();
+  mark = '+';
+  timeline.invalidate();
+  check();
+  window.move(Rectangle{12, 0, 18, 5});
+  check();
+  // Nothing beyond the screen has been rendered
+  CHECK_LE(widest, size.x());
+}
+
+TEST_CASE("Surface deferred updates") {
+  Screen screen{Vector{30, 15}};
+  ScreenTerminal term{screen, Surface::Compositor::fragments};
+  Window form{&term, Rectangle{1, 1, 25, 12}, Char('.')};
+  Window popup{&term, Rectangle{10, 2, 20, 6}, Char('p')};
+  auto label{std::make_unique<Window>(&term, Rectangle{0, 12, 5, 13}, Char('l'))};
+  screen.calls_ = 0;
+  term.deferUpdates(true);
+  CHECK(term.deferUpdates());
+  for (auto i = 0; i < 50; ++i) {
+    form.write(Vector{Dim(i % 20), Dim(i / 20)}, "x");
+  }
+  label->write(Vector{0, 0}, "gone");
+  label.reset();
+  popup.move(Rectangle{12, 3, 22, 7});
+  const auto moved{screen.calls_};
+  form.write(Vector{0, 5}, "late");
+  CHECK_EQ(screen.calls_, moved);
+  term.flush();
+  CHECK_EQ(screen.calls_, moved + 1);
+  term.flush();
+  CHECK_EQ(screen.calls_, moved + 1);
+  const auto expected{ExpectedScreen(term, Vector{30, 15})};
+  CHECK_EQ(screen.text_.repr(), expected.repr());
+  form.write(Vector{0, 6}, "off");
+  term.deferUpdates(false);
+  CHECK_EQ(screen.calls_, moved + 2);
+  CHECK_NE(screen.text_.repr().find("off"), string::npos);
+}
+
+TEST_CASE("Surface scrolling") {
+  const Vector size{30, 15};
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    ShiftingScreen screen{size};
+    ScreenTerminal term{screen, compositor};
+    Window log{&term, Rectangle{2, 2, 22, 10}, Char('.')};
+    Window popup{&term, Rectangle{15, 6, 28, 12}, Char('p')};
+    const auto check{[&]() {
+      const auto expected{ExpectedScreen(term, size)};
+      REQUIRE_EQ(screen.text_.repr(), expected.repr());
+    }};
+    for (auto i = 0; i < 20; ++i) {
+      log.scroll(Rectangle{0, 1, 20, 8});
+      log.write(Vector{0, 7}, std::format("line {}", i));
+      check();
+    }
+    log.scroll(Rectangle{0, 1, 20, 8}, -3);
+    check();
+    log.scroll(Rectangle{0, 1, 20, 8}, 10);
+    check();
+    CHECK_GT(screen.moved_, 0);
+    // Scrolling in a transaction is moved on the device by the commit
+    const auto moved{screen.moved_};
+    {
+      const Surface::Transaction transaction{term};
+      for (auto i = 0; i < 3; ++i) {
+        log.scroll(Rectangle{0, 1, 20, 8});
+        log.write(Vector{0, 7}, std::format("frame {}", i));
+      }
+      log.scroll(Rectangle{0, 1, 20, 8}, -2);
+    }
+    check();
+    CHECK_GT(screen.moved_, moved);
+    // Deferred updates of the area are not on the device yet
+    term.deferUpdates(true);
+    log.write(Vector{0, 7}, "pending");
+    log.scroll(Rectangle{0, 1, 20, 8});
+    term.deferUpdates(false);
+    check();
+  }
+}
+
+TEST_CASE("Surface unchanged writes") {
+  Screen screen{Vector{30, 15}};
+  ScreenTerminal term{screen, Surface::Compositor::fragments};
+  Window dashboard{&term, Rectangle{2, 2, 22, 8}, Char('.')};
+  dashboard.write(Vector{1, 1}, "load 0.5");
+  screen.calls_ = 0;
+  for (auto i = 0; i < 10; ++i) {
+    dashboard.write(Vector{1, 1}, "load 0.5");
+    dashboard.fill(Char('.'), Rectangle{1, 3, 10, 5});
+  }
+  CHECK_EQ(screen.calls_, 0);
+  dashboard.write(Vector{1, 1}, "load 0.7");
+  CHECK_EQ(screen.calls_, 1);
+  CHECK_NE(screen.text_.repr().find("load 0.7"), string::npos);
+}
+
+TEST_CASE("Surface hidden elements") {
+  for (const auto compositor: {Surface::Compositor::fragments, Surface::Compositor::ownershipMap}) {
+    INFO("Compositor: ", int(compositor));
+    Screen screen{Vector{30, 15}};
+    ScreenTerminal term{screen, compositor};
+    Window log{&term, Rectangle{2, 2, 12, 6}, Char('.')};
+    Window cover{&term, Rectangle{0, 0, 20, 10}, Char('c')};
+    CHECK_FALSE(log.visible());
+    CHECK(cover.visible());
+    screen.calls_ = 0;
+    for (auto i = 0; i < 20; ++i) {
+      log.write(Vector{0, Dim(i % 4)}, std::format("line {}", i));
+    }
+    CHECK_EQ(screen.calls_, 0);
+    term.deferUpdates(true);
+    log.write(Vector{0, 0}, "deferred");
+    CHECK_FALSE(term.changed());
+    term.deferUpdates(false);
+    CHECK_EQ(screen.calls_, 0);
+    cover.move(Rectangle{15, 0, 35, 10});
+    CHECK(log.visible());
+    const auto expected{ExpectedScreen(term, Vector{30, 15})};
+    CHECK_EQ(screen.text_.repr(), expected.repr());
+    CHECK_NE(screen.text_.repr().find("deferred"), string::npos);
+  }
+}
+
+TEST_CASE("Fragment indexes") {
+  const vector<Rectangle> areas{
+    Rectangle{DimLow, DimLow, DimHigh, -3},
+    Rectangle{DimLow, -3, 0, DimHigh},
+    Rectangle{0, -3, 5, 2},
+    Rectangle{5, -3, DimHigh, 2},
+    Rectangle{0, 2, 3, 40},
+    Rectangle{3, 2, DimHigh, 40},
+    Rectangle{0, 40, DimHigh, DimHigh},
+  };
+  const vector<Vector> positions{
+    Vector{DimLow, DimLow}, Vector{-1, -4}, Vector{-1, -3}, Vector{0, -3}, Vector{4, 1}, Vector{5, 1},
+    Vector{2, 2}, Vector{3, 39}, Vector{0, 40}, Vector{7, 1000}, Vector{Dim(DimHigh - 1), 7}
+  };
+  for (const auto grid: {false, true}) {
+    INFO("Grid: ", grid);
+    std::unique_ptr<FragmentIndex> index;
+    if (grid) {
+      index = std::make_unique<GridIndex>();
+    } else {
+      index = std::make_unique<RtreeIndex>();
+    }
+    // Insert bounded areas first so that rows are added later
+    for (const auto handle: {4U, 2U, 3U, 5U, 0U, 6U, 1U}) {
+      index->insert(areas[handle], handle);
+    }
+    CHECK_EQ(index->size(), areas.size());
+    const vector<std::optional<FragmentHandle>> expected{0, 0, 1, 2, 2, 3, 4, 5, 6, 6, 5};
+    for (size_t i = 0; i < positions.size(); ++i) {
+      INFO("Position ", string(positions[i]));
+      CHECK_EQ(index->find(positions[i]), expected[i]);
+    }
+    // Touching fragments do not intersect
+    const auto found{[&index](const Rectangle &area) {
+      auto result{index->find(area)};
+      std::ranges::sort(result);
+      return result;
+    }};
+    CHECK_EQ(found(Rectangle{-1, -4, 1, -2}), vector<FragmentHandle>{0, 1, 2});
+    CHECK_EQ(found(Rectangle{3, 2, 5, 40}), vector<FragmentHandle>{5});
+    CHECK_EQ(found(Rectangle{7, 100, 9, 1000}), vector<FragmentHandle>{6});
+    CHECK_EQ(found(Rectangle{-10, -10, -5, 0}), vector<FragmentHandle>{0, 1});
+    CHECK(found(Rectangle{0, 0, 0, 5}).empty());
+    index->remove(areas[2], 2);
+    index->remove(areas[2], 2);
+    CHECK_EQ(index->size(), areas.size() - 1);
+    CHECK_FALSE(index->find(Vector{4, 1}));
+    index->insert(Rectangle{0, -3, 5, 1}, 2);
+    CHECK_EQ(index->find(Vector{4, 0}), FragmentHandle{2});
+    CHECK_FALSE(index->find(Vector{4, 1}));
+  }
+}
+
+TEST_CASE("Surface ownership map fragments") {
+  Device dev;
+  Terminal term{dev};
+  Surface &scr{*term.surface()};
+  Window win1{&term, Rectangle{1, 1, 9, 5}};
+  Window win2{&term, Rectangle{2, 0, 8, 6}, '.'_C, &win1};
+  scr.compositor(Surface::Compositor::ownershipMap);
+  TestRtree(scr);
+  CHECK_EQ(
+    scr.zorder()[0]->fragments(), vector<Surface::Fragment>{
+      Surface::Fragment{Rectangle{0, 0, 2, 1}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{8, 0, DimHigh, 1}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{0, 1, 1, 5}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{9, 1, DimHigh, 5}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{0, 5, 2, 6}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{8, 5, DimHigh, 6}, scr.zorder()[0]},
+      Surface::Fragment{Rectangle{0, 6, DimHigh, DimHigh}, scr.zorder()[0]}
+    }
+  );
+  CHECK_EQ(
+    win2.fragments(),
+    vector<Surface::Fragment>{Surface::Fragment{Rectangle{2, 0, 8, 1}, &win2}, Surface::Fragment{Rectangle{2, 5, 8, 6}, &win2}}
+  );
+  CHECK_EQ(win1.fragments(), vector<Surface::Fragment>{Surface::Fragment{Rectangle{1, 1, 9, 5}, &win1}});
+  SUBCASE("ReshapeWindow") {
+    dev.updates_.clear();
+    scr.reshapeElement(&win2, Rectangle{4, 0, 10, 6});
+    TestRtree(scr);
+    std::ranges::sort(dev.updates_);
+    CHECK_EQ(
+      dev.updates_,
+      Updates{
+        {
+          {Vector{2, 0}, Text("  ")},
+          {Vector{2, 5}, Text("  ")},
+          {Vector{4, 0}, Text("......")},
+          {Vector{4, 5}, Text("......")},
+          {Vector{9, 1}, Text(".\n.\n.\n.")}
+        }
+      }
+    );
+    CHECK_EQ(
+      win2.fragments(),
+      vector<Surface::Fragment>{
+        Surface::Fragment{Rectangle{4, 0, 10, 1}, &win2},
+        Surface::Fragment{Rectangle{9, 1, 10, 5}, &win2},
+        Surface::Fragment{Rectangle{4, 5, 10, 6}, &win2}
+      }
+    );
+  }
+  SUBCASE("Back to fragments") {
+    scr.compositor(Surface::Compositor::fragments);
+    TestRtree(scr);
+    CHECK_EQ(win1.fragments(), vector<Surface::Fragment>{Surface::Fragment{Rectangle{1, 1, 9, 5}, &win1}});
+  }
+}
+
 // NOLINTEND(misc-use-anonymous-namespace)
 // NOLINTEND(readability-magic-numbers)
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -1,13 +1,25 @@
 #include <term/geometry.hh>
+#include <term/replay.hh>
+#include <term/spsc_ring.hh>
 #include <term/term.hh>
 #include <term/text.hh>
 
+#include <array>
+#include <chrono>
 #include <cstdio>
+#include <format>
 #include <doctest/doctest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
 
 using
   jwezel::operator""_C,
+  jwezel::Dim,
   jwezel::Rectangle,
+  jwezel::Replay,
+  jwezel::SpscRing,
   jwezel::string,
   jwezel::Terminal,
   jwezel::Text,
@@ -67,6 +79,255 @@ TEST_CASE("Terminal") {
   }
 }
 
+TEST_CASE("Terminal window moves") {
+  auto *output{tmpfile()};
+  std::array<int, 2> pipe_{};
+  REQUIRE_EQ(pipe(pipe_.data()), 0);
+  Replay::start(pipe_[1], Vector{20, 10});
+  // Primary device attributes with rectangular editing
+  CHECK_EQ(write(pipe_[1], "\x1b[?64;28c", 10), 10);
+  Terminal term('.'_C, VectorMin, Vector{20, 10}, VectorMax, output->_fileno, pipe_[0]);
+  REQUIRE(term.display().rectangularEditing(true));
+  Window window{&term, Rectangle{2, 2, 16, 6}, 'w'_C};
+  for (Dim line = 0; line < 4; ++line) {
+    window.write(Vector{0, line}, std::format("content line {}", line));
+  }
+  const auto check{[&]() {
+    Text expected{'.'_C, Vector{20, 10}};
+    expected.patch(window.text(), window.area().position());
+    CHECK_EQ(term.display().text().repr(), expected.repr());
+  }};
+  check();
+  // Only the strips left behind are written besides the copy
+  const auto written{term.display().written()};
+  window.move(Rectangle{3, 3, 17, 7});
+  check();
+  CHECK_LT(term.display().written() - written, 80);
+  // The terminal copies the window with DECCRA
+  const auto copies{[&output]() {
+    std::string content(size_t(lseek(output->_fileno, 0, SEEK_END)), '\0');
+    CHECK_EQ(pread(output->_fileno, content.data(), content.size(), 0), content.size());
+    size_t result{0};
+    for (auto position = content.find("$v"); position != std::string::npos; position = content.find("$v", position + 1)) {
+      ++result;
+    }
+    return result;
+  }};
+  CHECK_EQ(copies(), 1);
+  SUBCASE("Frames") {
+    // A drag collected in a frame is copied once the frame is rendered
+    term.frameRate(1000);
+    for (Dim x = 2; x >= 0; --x) {
+      window.move(Rectangle{x, 3, Dim(x + 14), 7});
+    }
+    CHECK_EQ(copies(), 1);
+    REQUIRE(term.nextFrame());
+    std::this_thread::sleep_until(term.nextFrame().value());
+    CHECK(term.frame());
+    check();
+    CHECK_GT(copies(), 1);
+    term.frameRate(0);
+  }
+  (void)close(pipe_[0]);
+  (void)close(pipe_[1]);
+}
+
+TEST_CASE("Replay") {
+  auto *output{tmpfile()};
+  auto *recording{tmpfile()};
+  std::array<int, 2> pipe_{};
+  REQUIRE_EQ(pipe(pipe_.data()), 0);
+  Replay::start(pipe_[1], Vector{20, 10});
+  {
+    Terminal term('.'_C, VectorMin, VectorMin, VectorMax, output->_fileno, pipe_[0]);
+    term.keyboard().record(recording->_fileno);
+    CHECK_EQ(write(pipe_[1], "ab", 2), 2);
+    CHECK_EQ(term.keyboard().key(), 'a');
+    CHECK(term.keyboard().pending());
+    CHECK_EQ(term.keyboard().key(), 'b');
+    CHECK_FALSE(term.keyboard().pending());
+    CHECK_EQ(write(pipe_[1], "\x1b[Ac", 4), 4);
+    CHECK_EQ(term.keyboard().key(), jwezel::Up);
+    CHECK_EQ(term.keyboard().key(), 'c');
+  }
+  (void)fseek(recording, 0, SEEK_SET);
+  const Replay replay{recording->_fileno};
+  REQUIRE_EQ(replay.inputs().size(), 2);
+  CHECK_EQ(replay.inputs()[0].bytes, "ab");
+  CHECK_EQ(replay.inputs()[1].bytes, "\x1b[Ac");
+  CHECK_LE(replay.inputs()[0].time, replay.inputs()[1].time);
+  Replay::start(pipe_[1], Vector{20, 10});
+  Terminal term('.'_C, VectorMin, VectorMin, VectorMax, output->_fileno, pipe_[0]);
+  const auto statistics{replay.run(term, pipe_[1])};
+  CHECK_EQ(statistics.size(), 4);
+  CHECK_FALSE(term.keyboard().pending());
+  SUBCASE("Sequence split between chunks") {
+    auto *split{tmpfile()};
+    // Mouse report \x1b[<0;1;1M cut after the first parameter
+    (void)fputs("0 1b5b3c303b\n1000 313b314d\n", split);
+    (void)fseek(split, 0, SEEK_SET);
+    const Replay splitReplay{split->_fileno};
+    REQUIRE_EQ(splitReplay.inputs().size(), 2);
+    CHECK_EQ(splitReplay.run(term, pipe_[1], true).size(), 1);
+    CHECK_FALSE(term.keyboard().pending());
+  }
+  (void)close(pipe_[0]);
+  (void)close(pipe_[1]);
+}
+
+TEST_CASE("SpscRing") {
+  SpscRing<int, 4> ring;
+  CHECK_FALSE(ring.pop());
+  for (auto i = 0; i < 4; ++i) {
+    CHECK(ring.push(int{i}));
+  }
+  CHECK_FALSE(ring.push(4));
+  CHECK_EQ(ring.size(), 4);
+  CHECK_EQ(*ring.pop(), 0);
+  CHECK(ring.push(4));
+  for (auto i = 1; i < 5; ++i) {
+    ring.wait();
+    CHECK_EQ(*ring.pop(), i);
+  }
+  SUBCASE("Threads") {
+    static const auto Count{100000};
+    std::thread producer{[&ring] {
+      for (auto i = 0; i < Count; ++i) {
+        while (!ring.push(int{i})) {
+          ring.waitSpace();
+        }
+      }
+    }};
+    auto ordered{true};
+    for (auto i = 0; i < Count; ++i) {
+      ring.wait();
+      ordered = ordered and *ring.pop() == i;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK_EQ(ring.size(), 0);
+  }
+}
+
+TEST_CASE("Terminal input thread") {
+  auto *output{tmpfile()};
+  std::array<int, 2> pipe_{};
+  REQUIRE_EQ(pipe(pipe_.data()), 0);
+  Replay::start(pipe_[1], Vector{20, 10});
+  Terminal term('.'_C, VectorMin, VectorMin, VectorMax, output->_fileno, pipe_[0]);
+  term.inputThread(true);
+  CHECK(term.inputThread());
+  const auto written{std::chrono::steady_clock::now()};
+  CHECK_EQ(write(pipe_[1], "a\x1b[Ab", 5), 5);
+  for (const auto key: {jwezel::Unicode{'a'}, jwezel::Unicode{jwezel::Up}, jwezel::Unicode{'b'}}) {
+    auto event{term.event()};
+    REQUIRE_EQ(event.type(), jwezel::KeyEvent::type_);
+    CHECK_EQ(dynamic_cast<jwezel::KeyEvent *>(event())->key(), key);
+    CHECK(event.time() >= written);
+    CHECK(event.time() <= std::chrono::steady_clock::now());
+  }
+  SUBCASE("Stop") {
+    term.inputThread(false);
+    CHECK_FALSE(term.inputThread());
+    CHECK_EQ(write(pipe_[1], "c", 1), 1);
+    CHECK_EQ(dynamic_cast<jwezel::KeyEvent *>(term.event()())->key(), 'c');
+  }
+  SUBCASE("Frames while waiting") {
+    term.frameRate(100);
+    Window window{&term, Rectangle{2, 2, 12, 6}, 'w'_C};
+    const auto before{term.display().written()};
+    // Without input, runEvent renders the frame when it is due
+    term.runEvent();
+    CHECK_GT(term.display().written(), before);
+    CHECK_FALSE(term.nextFrame());
+    CHECK_EQ(write(pipe_[1], "d", 1), 1);
+    window.write(Vector{0, 0}, "x");
+    REQUIRE(term.nextFrame());
+    const auto due{term.nextFrame().value()};
+    CHECK_EQ(dynamic_cast<jwezel::KeyEvent *>(term.event()())->key(), 'd');
+    term.runEvent();
+    CHECK_GE(std::chrono::steady_clock::now(), due);
+    term.frameRate(0);
+  }
+  SUBCASE("Stop within sequence") {
+    // The thread waits for the rest of the mouse report
+    CHECK_EQ(write(pipe_[1], "\x1b[<0;", 5), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    term.inputThread(false);
+    CHECK_FALSE(term.inputThread());
+  }
+  SUBCASE("Stop with full queue") {
+    // The thread waits for room in the queue of 256 events
+    const std::string keys(300, 'x');
+    CHECK_EQ(write(pipe_[1], keys.data(), keys.size()), keys.size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    term.inputThread(false);
+    CHECK_FALSE(term.inputThread());
+  }
+  SUBCASE("Error") {
+    (void)close(pipe_[1]);
+    pipe_[1] = -1;
+    CHECK_THROWS_AS((void)term.event(), std::runtime_error);
+    CHECK_FALSE(term.inputThread());
+  }
+  (void)close(pipe_[0]);
+  if (pipe_[1] >= 0) {
+    (void)close(pipe_[1]);
+  }
+}
+
+TEST_CASE("Terminal frame rate") {
+  auto *output{tmpfile()};
+  std::array<int, 2> pipe_{};
+  REQUIRE_EQ(pipe(pipe_.data()), 0);
+  Replay::start(pipe_[1], Vector{20, 10});
+  Terminal term('.'_C, VectorMin, VectorMin, VectorMax, output->_fileno, pipe_[0]);
+  CHECK_FALSE(term.nextFrame());
+  term.frameRate(1000);
+  CHECK_EQ(term.frameRate(), 1000);
+  CHECK(term.frame() == false);
+  const auto written{term.display().written()};
+  Window window{&term, Rectangle{2, 2, 12, 6}, 'w'_C};
+  for (auto i = 0; i < 100; ++i) {
+    window.write(Vector{0, 0}, std::format("{:3}", i));
+  }
+  CHECK_EQ(term.display().written(), written);
+  REQUIRE(term.nextFrame());
+  std::this_thread::sleep_until(term.nextFrame().value());
+  CHECK(term.frame());
+  CHECK_GT(term.display().written(), written);
+  CHECK_FALSE(term.nextFrame());
+  CHECK_FALSE(term.frame());
+  // Without input, runEvent renders the next frame when it is due
+  window.write(Vector{0, 1}, "x");
+  const auto before{term.display().written()};
+  term.runEvent();
+  CHECK_GT(term.display().written(), before);
+  term.frameRate(0);
+  CHECK_FALSE(term.inTransaction());
+  (void)close(pipe_[0]);
+  (void)close(pipe_[1]);
+}
+
+TEST_CASE("Terminal frame at destruction") {
+  auto *output{tmpfile()};
+  std::array<int, 2> pipe_{};
+  REQUIRE_EQ(pipe(pipe_.data()), 0);
+  Replay::start(pipe_[1], Vector{20, 10});
+  {
+    Terminal term('.'_C, VectorMin, Vector{10, 2}, VectorMax, output->_fileno, pipe_[0]);
+    term.frameRate(1);
+    term.desktop().write(Vector{0, 0}, "pending");
+    CHECK(term.nextFrame());
+  }
+  // The pending frame is rendered when the terminal is destroyed
+  std::string content(size_t(lseek(output->_fileno, 0, SEEK_END)), '\0');
+  CHECK_EQ(pread(output->_fileno, content.data(), content.size(), 0), content.size());
+  CHECK_NE(content.find("pending"), std::string::npos);
+  (void)close(pipe_[0]);
+  (void)close(pipe_[1]);
+}
+
 // NOLINTEND(readability-magic-numbers)
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
 // NOLINTEND(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
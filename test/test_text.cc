@@ -233,6 +233,25 @@ TEST_CASE("Text") {
       t2.patch(Text("xx\nyy", attr), Vector(-2, -1));
       CHECK_EQ(t2, Text("line1\nline 2", attr));
     }
+    SUBCASE("Patch changes") {
+      auto t2 = text;
+      CHECK_EQ(t2.patch(Text("xn\nyy", attr), Vector(1, 0)), Rectangle{1, 0, 3, 2});
+      CHECK_EQ(t2.patch(Text("xn\nyy", attr), Vector(1, 0)), std::nullopt);
+      CHECK_EQ(t2.patch(Text("xz\nyy", attr), Vector(1, 0)), Rectangle{2, 0, 3, 1});
+      CHECK_EQ(t2.patchArea(Text("lx", attr), Rectangle{0, 1, 2, 2}), Rectangle{1, 1, 2, 2});
+      CHECK_EQ(t2.fill(Char('z', attr), Rectangle{2, 0, 3, 1}), std::nullopt);
+      CHECK_EQ(t2.fill(Char('z', attr), Rectangle{2, 0, 4, 1}), Rectangle{3, 0, 4, 1});
+      CHECK_EQ(t2.setAttr(attr, Rectangle{0, 0, 2, 2}), std::nullopt);
+    }
+    SUBCASE("Scroll") {
+      auto t2 = text;
+      CHECK_EQ(t2.scroll(jwezel::RectangleMax, 1, Char('.', attr)), Rectangle{0, 0, 6, 2});
+      CHECK_EQ(t2, Text("line 2\n......", attr));
+      t2 = text;
+      CHECK_EQ(t2.scroll(Rectangle{1, 0, 3, 5}, -1, Char('.', attr)), Rectangle{1, 0, 3, 2});
+      CHECK_EQ(t2, Text("l..e1\nline 2", attr));
+      CHECK_EQ(t2.scroll(Rectangle{1, 0, 3, 2}, 0), std::nullopt);
+    }
     SUBCASE("setAttr") {
       auto t2 = text;
       t2.setAttr(CharAttributes(RgbGreen, RgbYellow, jwezel::reverse, jwezel::AttributeMode::replace), Rectangle{0, 0, 2, 2});